@@ -0,0 +1,69 @@
+/**
+ */
+
+#include "allocationcounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t sThreadAllocations(0);
+}
+
+//========================================================================
+bool AllocationCounter::isEnabled()
+{
+#ifdef FALLOUT_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t AllocationCounter::getThreadCount()
+{
+    return sThreadAllocations;
+}
+
+#ifdef FALLOUT_COUNT_ALLOCATIONS
+//------------------------------------------------------------------------
+// The array, nothrow and sized forms in libstdc++ all forward to these,
+// the sized deletes are replaced below only to keep the build quiet.
+void *operator new(std::size_t size)
+{
+    ++sThreadAllocations;
+    if (void *block = std::malloc(size ? size : 1))
+        return block;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++sThreadAllocations;
+    std::size_t align(static_cast<std::size_t>(alignment));
+    if (void *block = std::aligned_alloc(align, size ? ((size + align - 1) / align) * align : align))
+        return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+// Replacing only the unsized deletes draws -Wsized-deallocation.
+void operator delete(void *block, std::size_t) noexcept
+{
+    ::operator delete(block);
+}
+
+void operator delete(void *block, std::size_t, std::align_val_t alignment) noexcept
+{
+    ::operator delete(block, alignment);
+}
+#endif
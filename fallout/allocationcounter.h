@@ -0,0 +1,20 @@
+/**
+ */
+
+#ifndef FALLOUT_ALLOCATIONCOUNTER_H
+#define FALLOUT_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+//========================================================================
+// Counts heap allocations made by the calling thread.  Only active when
+// built with FALLOUT_COUNT_ALLOCATIONS, which replaces the global
+// operator new; otherwise the count stays at zero.
+class AllocationCounter
+{
+public:
+    static bool             isEnabled();
+    static uint64_t         getThreadCount();
+};
+
+#endif // !FALLOUT_ALLOCATIONCOUNTER_H
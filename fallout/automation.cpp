@@ -0,0 +1,324 @@
+/**
+ */
+
+#include "automation.h"
+#include "allocationcounter.h"
+#include "gameboard.h"
+#include "nullrenderer.h"
+#include "sessionloop.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//========================================================================
+ScriptRunner::ScriptRunner(const WordLibrary::ptr_t &library, const OptionsData::ptr_t &opts):
+    mLibrary(library),
+    mBoards(),
+    mEvents(),
+    mStats(),
+    mOpts(opts),
+    mSessions(),
+    mNextSession(0)
+{
+}
+
+bool ScriptRunner::loadScripts()
+{
+    for (const std::string &script : mOpts->mScripts)
+    {
+        bool success(false);
+
+        if (script == "-")
+        {
+            success = ScriptInput::parseScript(std::cin, "<stdin>", mSessions);
+        }
+        else
+        {
+            std::ifstream file(script);
+            if (file.fail())
+            {
+                std::cerr << "Unable to open \"" << script << "\"" << std::endl;
+                return false;
+            }
+            success = ScriptInput::parseScript(file, script, mSessions);
+        }
+
+        if (!success)
+            return false;
+    }
+
+    std::cerr << "Loaded " << mSessions.size() << " scripted sessions." << std::endl;
+    return true;
+}
+
+int ScriptRunner::run()
+{
+    if (mOpts->mScriptMultiplex)
+        return runMultiplexed();
+
+    int thread_count(mOpts->mScriptThreads);
+    if (thread_count <= 0)
+        thread_count = std::max(1, (int)std::thread::hardware_concurrency());
+    thread_count = (int)std::min<size_t>(thread_count, std::max<size_t>(1, mSessions.size()));
+
+    std::vector<Results> results(thread_count);
+    std::vector<std::thread> threads;
+
+    mNextSession = 0;
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    for (int i = 1; i < thread_count; ++i)
+    {
+        threads.emplace_back(&ScriptRunner::worker, this, std::ref(results[i]));
+    }
+    worker(results[0]);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+
+    Results total;
+    for (const Results &result : results)
+    {
+        total.mSessions += result.mSessions;
+        total.mWins += result.mWins;
+        total.mAllocations += result.mAllocations;
+        total.mLatency.merge(result.mLatency);
+    }
+
+    report(total, thread_count, elapsed.count());
+
+    if (AllocationCounter::isEnabled())
+    {   // the first session on each thread warms up, after that the
+        // game loop must not touch the heap
+        std::cout << "Allocations:      " << total.mAllocations << " after warmup" << std::endl;
+        if (total.mAllocations)
+            return 1;
+    }
+
+    return 0;
+}
+
+int ScriptRunner::runMultiplexed()
+{
+    Results total;
+
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    if (is_standard_geometry(*mOpts))
+        multiplexSessions<GameBoard>(StandardGeometry(), total);
+    else
+        multiplexSessions<RuntimeGameBoard>(runtime_geometry(*mOpts), total);
+
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+
+    report(total, 1, elapsed.count());
+    return 0;
+}
+
+void ScriptRunner::report(const Results &total, int thread_count, double seconds)
+{
+    seconds = std::max(seconds, 1e-9);
+    std::cout << std::fixed << std::setprecision(3) <<
+        "Sessions:         " << total.mSessions << " (" << total.mWins << " won)" << std::endl <<
+        "Keystrokes:       " << total.mLatency.getCount() << std::endl <<
+        "Threads:          " << thread_count << std::endl <<
+        "Elapsed:          " << seconds << " s" << std::endl <<
+        "Sessions/sec:     " << (total.mSessions / seconds) << std::endl <<
+        "Keystrokes/sec:   " << (total.mLatency.getCount() / seconds) << std::endl <<
+        "Latency mean:     " << (total.mLatency.getMean() / 1000.0) << " us" << std::endl <<
+        "Latency p50:      " << (total.mLatency.percentile(0.50) / 1000.0) << " us" << std::endl <<
+        "Latency p90:      " << (total.mLatency.percentile(0.90) / 1000.0) << " us" << std::endl <<
+        "Latency p99:      " << (total.mLatency.percentile(0.99) / 1000.0) << " us" << std::endl <<
+        "Latency max:      " << (total.mLatency.getMax() / 1000.0) << " us" << std::endl;
+}
+
+void ScriptRunner::worker(Results &results)
+{
+    Renderer::ptr_t renderer(std::make_shared<NullRenderer>());
+    std::shared_ptr<ScriptInput> input(std::make_shared<ScriptInput>());
+
+    if (is_standard_geometry(*mOpts))
+    {
+        GameBoard board(renderer, input, mLibrary, mOpts);
+        runSessions(board, *input, results);
+    }
+    else
+    {
+        RuntimeGameBoard board(renderer, input, mLibrary, mOpts, runtime_geometry(*mOpts));
+        runSessions(board, *input, results);
+    }
+}
+
+template<class BOARD>
+void ScriptRunner::runSessions(BOARD &board, ScriptInput &input, Results &results)
+{
+    bool warm(false);
+
+    board.setBoardLibrary(mBoards);
+    board.setEventLog(mEvents);
+    board.setStats(mStats);
+
+    while (true)
+    {
+        size_t index(mNextSession++);
+        if (index >= mSessions.size())
+            break;
+
+        const ScriptSession &session(mSessions[index]);
+        input.reset(session);
+        board.seed(session.mSeed);
+
+        uint64_t allocations(AllocationCounter::getThreadCount());
+        if (board.playSession())
+            ++results.mWins;
+        input.finish();
+        ++results.mSessions;
+
+        if (warm)
+            results.mAllocations += AllocationCounter::getThreadCount() - allocations;
+        warm = true;
+
+        for (const ScriptInput::clock_t::duration &latency : input.getLatencies())
+        {
+            results.mLatency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+        }
+    }
+}
+
+template<class BOARD>
+void ScriptRunner::multiplexSessions(const typename BOARD::geometry_t &geometry, Results &results)
+{
+    // Every session gets its own board, all of them live at once.  The
+    // boards never read their input source, their keys come through the
+    // loop.
+    Renderer::ptr_t renderer(std::make_shared<NullRenderer>());
+    InputSource::ptr_t input(std::make_shared<ScriptInput>());
+
+    std::vector<std::unique_ptr<BOARD> > boards;
+    std::deque<KeyChannel> channels(mSessions.size());
+    SessionLoop loop;
+
+    boards.reserve(mSessions.size());
+    for (size_t i = 0; i < mSessions.size(); ++i)
+    {
+        boards.push_back(std::make_unique<BOARD>(renderer, input, mLibrary, mOpts, geometry));
+        boards.back()->setBoardLibrary(mBoards);
+        boards.back()->setEventLog(mEvents);
+        boards.back()->setStats(mStats);
+        boards.back()->seed(mSessions[i].mSeed);
+        loop.add(boards.back()->runSession(channels[i]), channels[i]);
+    }
+
+    // Stands in for the network: interleaves the sessions' keys one
+    // round at a time, ending each session's input after its last key.
+    std::thread feeder([this, &loop] {
+        for (size_t round = 0; ; ++round)
+        {
+            bool more(false);
+            for (size_t i = 0; i < mSessions.size(); ++i)
+            {
+                const std::vector<int> &keys(mSessions[i].mKeys);
+                if (round < keys.size())
+                    loop.post(i, keys[round]);
+                else if (round == keys.size())
+                    loop.post(i, InputSource::sEndOfInput);
+                more = more || (round < keys.size());
+            }
+            if (!more)
+                break;
+        }
+        loop.close();
+    });
+
+    loop.run([&results](SessionLoop::clock_t::duration latency) {
+        results.mLatency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+    });
+    feeder.join();
+
+    for (size_t i = 0; i < loop.getSessionCount(); ++i)
+    {
+        const SessionTask &session(loop.getSession(i));
+        if (!session.done())
+            continue;
+
+        ++results.mSessions;
+        if (session.result())
+            ++results.mWins;
+    }
+}
+
+//========================================================================
+ScriptRunner::LatencyHistogram::LatencyHistogram():
+    mBuckets(),
+    mCount(0),
+    mTotal(0),
+    mMax(0)
+{
+    mBuckets.fill(0);
+}
+
+void ScriptRunner::LatencyHistogram::add(std::chrono::nanoseconds latency)
+{
+    uint64_t value(latency.count() > 0 ? latency.count() : 0);
+
+    ++mBuckets[bucketFor(value)];
+    ++mCount;
+    mTotal += value;
+    mMax = std::max(mMax, value);
+}
+
+void ScriptRunner::LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < sBuckets; ++i)
+    {
+        mBuckets[i] += other.mBuckets[i];
+    }
+    mCount += other.mCount;
+    mTotal += other.mTotal;
+    mMax = std::max(mMax, other.mMax);
+}
+
+uint64_t ScriptRunner::LatencyHistogram::percentile(double fraction) const
+{
+    if (!mCount)
+        return 0;
+
+    uint64_t target(static_cast<uint64_t>(fraction * mCount));
+    uint64_t seen(0);
+    for (int i = 0; i < sBuckets; ++i)
+    {
+        seen += mBuckets[i];
+        if (seen > target)
+            return std::min(bucketLimit(i), mMax);
+    }
+    return mMax;
+}
+
+int ScriptRunner::LatencyHistogram::bucketFor(uint64_t value)
+{
+    if (value < sSubBuckets)
+        return static_cast<int>(value);
+
+    int magnitude(63 - __builtin_clzll(value));     // value >= 8, so magnitude >= 3
+    int step(static_cast<int>((value >> (magnitude - 3)) & (sSubBuckets - 1)));
+
+    return std::min(sBuckets - 1, ((magnitude - 2) * sSubBuckets) + step);
+}
+
+uint64_t ScriptRunner::LatencyHistogram::bucketLimit(int bucket)
+{
+    if (bucket < sSubBuckets)
+        return bucket;
+
+    int magnitude((bucket / sSubBuckets) + 2);
+    int step(bucket % sSubBuckets);
+
+    return ((uint64_t(sSubBuckets + step + 1)) << (magnitude - 3)) - 1;
+}
@@ -0,0 +1,98 @@
+/**
+ */
+
+#ifndef FALLOUT_AUTOMATION_H
+#define FALLOUT_AUTOMATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "fallout.h"
+#include "wordlibrary.h"
+#include "boardlibrary.h"
+#include "eventlog.h"
+#include "sharedstats.h"
+#include "inputsource.h"
+
+//========================================================================
+// Replays scripted sessions headless, one board per worker thread, and
+// reports throughput and per-keystroke latency.  With --script-multiplex
+// every session gets a board and they all run on one SessionLoop.
+class ScriptRunner
+{
+public:
+    ScriptRunner(const WordLibrary::ptr_t &library, const OptionsData::ptr_t &opts);
+
+    void                    setBoardLibrary(const BoardLibrary::ptr_t &boards) { mBoards = boards; }
+    void                    setEventLog(const EventLog::ptr_t &events)          { mEvents = events; }
+    void                    setStats(const SharedStats::ptr_t &stats)           { mStats = stats; }
+
+    bool                    loadScripts();
+    int                     run();
+
+private:
+    // Log-linear histogram: 8 linear steps inside each power of two of
+    // nanoseconds, enough for percentiles without keeping every sample.
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram();
+
+        void                add(std::chrono::nanoseconds latency);
+        void                merge(const LatencyHistogram &other);
+        uint64_t            percentile(double fraction) const;
+
+        uint64_t            getCount() const    { return mCount; }
+        uint64_t            getMax() const      { return mMax; }
+        double              getMean() const     { return mCount ? (double(mTotal) / mCount) : 0.0; }
+
+    private:
+        static const int    sSubBuckets = 8;
+        static const int    sBuckets = 64 * sSubBuckets;
+
+        static int          bucketFor(uint64_t value);
+        static uint64_t     bucketLimit(int bucket);
+
+        std::array<uint64_t, sBuckets>  mBuckets;
+        uint64_t            mCount;
+        uint64_t            mTotal;
+        uint64_t            mMax;
+    };
+
+    struct Results
+    {
+        Results():
+            mSessions(0),
+            mWins(0),
+            mAllocations(0),
+            mLatency()
+        {}
+
+        uint64_t            mSessions;
+        uint64_t            mWins;
+        uint64_t            mAllocations;   // after each worker's first session
+        LatencyHistogram    mLatency;
+    };
+
+    int                     runMultiplexed();
+    void                    report(const Results &total, int thread_count, double seconds);
+    void                    worker(Results &results);
+
+    template<class BOARD>
+    void                    runSessions(BOARD &board, ScriptInput &input, Results &results);
+
+    template<class BOARD>
+    void                    multiplexSessions(const typename BOARD::geometry_t &geometry, Results &results);
+
+    WordLibrary::ptr_t      mLibrary;
+    BoardLibrary::ptr_t     mBoards;
+    EventLog::ptr_t         mEvents;
+    SharedStats::ptr_t      mStats;
+    OptionsData::ptr_t      mOpts;
+    ScriptSession::vec_t    mSessions;
+    std::atomic<size_t>     mNextSession;
+};
+
+#endif // !FALLOUT_AUTOMATION_H
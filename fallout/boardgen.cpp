@@ -0,0 +1,164 @@
+// boardgen.cpp : Bulk generates boards into a library for --board-library.
+//
+
+#include "fallout.h"
+#include "gamedata.h"
+#include "gameboard.h"
+#include "boardlibrary.h"
+#include "inputsource.h"
+#include "nullrenderer.h"
+#include "wordlibrary.h"
+#include <boost/program_options.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    namespace bpo = boost::program_options;
+
+    struct BoardgenOptions
+    {
+        std::string     mDataFile;
+        std::string     mOutputFile;
+        std::string     mTierWeighting;
+        uint64_t        mCount;
+        int             mThreads;
+        int             mDifficulty;
+        unsigned int    mSeed;
+    };
+
+    void generate(const WordLibrary::ptr_t &words, const OptionsData::ptr_t &opts, const BoardgenOptions &gen,
+        BoardLibraryWriter &writer, std::atomic<uint64_t> &next)
+    {
+        Renderer::ptr_t renderer(std::make_shared<NullRenderer>());
+        InputSource::ptr_t input(std::make_shared<ScriptInput>());
+        GameBoard board(renderer, input, words, opts);
+
+        while (true)
+        {
+            uint64_t index(next++);
+            if (index >= gen.mCount)
+                break;
+
+            // Seed per board so the library does not depend on threading.
+            board.seed(gen.mSeed + static_cast<unsigned int>(index));
+            board.initialize();
+
+            char *record(writer.getRecord(index));
+            BoardRecordInfo &info(*reinterpret_cast<BoardRecordInfo *>(record));
+            char *cells(record + sizeof(BoardRecordInfo));
+
+            board.exportBoard(info, cells);
+            info.mSolveScore = uint8_t(std::lround(board.getScore().mExpectedGuesses * 4.0));
+        }
+    }
+
+    bool load_options(int argc, char **argv, BoardgenOptions &gen)
+    {
+        bpo::options_description options("Allowed Options");
+        options.add_options()
+            ("help,H",
+                "Produce this help message")
+            ("wordfile",    bpo::value<std::string>(),
+                "Word file, plain, gzip or zstd compressed (- for stdin)")
+            ("output",      bpo::value<std::string>(),
+                "Board library to write")
+            ("count",       bpo::value<uint64_t>()->default_value(100000),
+                "Boards to generate")
+            ("difficulty",  bpo::value<int>()->default_value(0),
+                "Difficulty of the boards (0-3)\n"
+                    "\t0 = Mixed")
+            ("tier-weighting", bpo::value<std::string>()->default_value("uniform"),
+                "How a word length is picked within a difficulty (uniform or size)")
+            ("seed",        bpo::value<unsigned int>()->default_value(1),
+                "Seed of the first board, board n uses seed + n")
+            ("threads",     bpo::value<int>()->default_value(0),
+                "Worker threads\n"
+                    "\t0 = One per CPU");
+
+        bpo::variables_map vm;
+        try
+        {
+            bpo::store(bpo::parse_command_line(argc, argv, options), vm);
+            bpo::notify(vm);
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << "Bad command line:" << std::endl << e.what() << std::endl;
+            std::cout << options << std::endl;
+            return false;
+        }
+
+        if (vm.count("help") || !vm.count("wordfile") || !vm.count("output"))
+        {
+            std::cout << argv[0] << std::endl <<
+                "Pre-generates boards for fallout --board-library." << std::endl << std::endl <<
+                options << std::endl;
+            return false;
+        }
+
+        gen.mDataFile = vm["wordfile"].as<std::string>();
+        gen.mOutputFile = vm["output"].as<std::string>();
+        gen.mCount = vm["count"].as<uint64_t>();
+        gen.mDifficulty = std::min(3, std::max(0, vm["difficulty"].as<int>()));
+        gen.mTierWeighting = vm["tier-weighting"].as<std::string>();
+        gen.mSeed = vm["seed"].as<unsigned int>();
+        gen.mThreads = vm["threads"].as<int>();
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BoardgenOptions gen;
+    if (!load_options(argc, argv, gen))
+        return -1;
+
+    FalloutWords::ptr_t words(std::make_shared<FalloutWords>((gen.mTierWeighting == "size") ?
+        FalloutWords::WEIGHT_SIZE : FalloutWords::WEIGHT_UNIFORM));
+    if (!words->loadWordList(gen.mDataFile, false) || !words->isPlayable())
+    {
+        std::cerr << "Unable to load a playable dictionary from \"" << gen.mDataFile << "\"" << std::endl;
+        return -1;
+    }
+
+    // Library boards are always generated with duds so their dud count
+    // can be partitioned on, the game decides whether to use them.
+    OptionsData::ptr_t opts(std::make_shared<OptionsData>());
+    opts->mDifficulty = gen.mDifficulty;
+    opts->mPowerups = true;
+    opts->mSinglePlay = true;
+
+    StandardGeometry geometry;
+    BoardLibraryWriter writer(geometry.getFields(), geometry.getWidth(), geometry.getHeight());
+    writer.resize(gen.mCount);
+
+    int thread_count(gen.mThreads);
+    if (thread_count <= 0)
+        thread_count = std::max(1, (int)std::thread::hardware_concurrency());
+
+    WordLibrary::ptr_t library(std::make_shared<WordLibrary>(words));
+    std::atomic<uint64_t> next(0);
+    std::vector<std::thread> threads;
+
+    std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    for (int i = 1; i < thread_count; ++i)
+    {
+        threads.emplace_back(generate, library, opts, std::cref(gen), std::ref(writer), std::ref(next));
+    }
+    generate(library, opts, gen, writer, next);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+
+    std::cerr << "Generated " << gen.mCount << " boards on " << thread_count << " threads in " <<
+        elapsed.count() << " s" << std::endl;
+
+    return writer.write(gen.mOutputFile) ? 0 : -1;
+}
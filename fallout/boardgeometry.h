@@ -0,0 +1,86 @@
+/**
+ */
+
+#ifndef FALLOUT_BOARDGEOMETRY_H
+#define FALLOUT_BOARDGEOMETRY_H
+
+#include <array>
+#include <memory_resource>
+#include <vector>
+
+//========================================================================
+// Board layout known at compile time.  Index math folds to shifts and
+// multiplies and per-cell storage is a fixed std::array.
+template<int FIELDS, int WIDTH, int HEIGHT>
+class FixedGeometry
+{
+public:
+    static_assert((FIELDS > 0) && (WIDTH > 0) && (HEIGHT > 0), "Empty board geometry");
+
+    static constexpr int    sLength = FIELDS * WIDTH * HEIGHT;
+
+    template<class T> using storage_t = std::array<T, sLength>;
+
+    constexpr int   getFields() const       { return FIELDS; }
+    constexpr int   getWidth() const        { return WIDTH; }
+    constexpr int   getHeight() const       { return HEIGHT; }
+    constexpr int   getFieldLength() const  { return WIDTH * HEIGHT; }
+    constexpr int   getLength() const       { return sLength; }
+
+    constexpr int   convertToField(int position) const  { return position / (WIDTH * HEIGHT); }
+    constexpr int   convertToX(int position) const      { return (position % (WIDTH * HEIGHT)) % WIDTH; }
+    constexpr int   convertToY(int position) const      { return (position % (WIDTH * HEIGHT)) / WIDTH; }
+    constexpr int   convertToPosition(int field, int x, int y) const
+    {
+        return (field * (WIDTH * HEIGHT)) + (y * WIDTH) + x;
+    }
+
+    template<class T>
+    storage_t<T>    makeStorage(std::pmr::memory_resource *) const { return storage_t<T>(); }
+    template<class T>
+    void            allocate(storage_t<T> &) const {}
+};
+
+/// The layout of the original game, two fields of 12x17.
+typedef FixedGeometry<2, 12, 17>    StandardGeometry;
+
+//========================================================================
+// Board layout chosen at run time, for anything that is not standard.
+class RuntimeGeometry
+{
+public:
+    template<class T> using storage_t = std::pmr::vector<T>;
+
+    RuntimeGeometry(int fields, int width, int height):
+        mFields(fields),
+        mWidth(width),
+        mHeight(height)
+    {}
+
+    int             getFields() const       { return mFields; }
+    int             getWidth() const        { return mWidth; }
+    int             getHeight() const       { return mHeight; }
+    int             getFieldLength() const  { return mWidth * mHeight; }
+    int             getLength() const       { return mFields * mWidth * mHeight; }
+
+    int             convertToField(int position) const  { return position / getFieldLength(); }
+    int             convertToX(int position) const      { return (position % getFieldLength()) % mWidth; }
+    int             convertToY(int position) const      { return (position % getFieldLength()) / mWidth; }
+    int             convertToPosition(int field, int x, int y) const
+    {
+        return (field * getFieldLength()) + (y * mWidth) + x;
+    }
+
+    /// Empty storage that allocate() sizes from memory.
+    template<class T>
+    storage_t<T>    makeStorage(std::pmr::memory_resource *memory) const { return storage_t<T>(memory); }
+    template<class T>
+    void            allocate(storage_t<T> &storage) const { storage.resize(getLength()); }
+
+private:
+    int             mFields;
+    int             mWidth;
+    int             mHeight;
+};
+
+#endif // !FALLOUT_BOARDGEOMETRY_H
@@ -0,0 +1,246 @@
+/**
+ */
+
+#include "boardlibrary.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+    const char LIBRARY_MAGIC[8] = { 'F', 'O', 'B', 'L', 'I', 'B', 0, 0 };
+
+    size_t align8(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+
+    /// True if count items of size starting at offset end within limit,
+    /// without overflowing on the way.
+    bool fits_within(uint64_t offset, uint64_t count, uint64_t size, uint64_t limit)
+    {
+        return (offset <= limit) && (!size || (count <= (limit - offset) / size));
+    }
+
+    std::tuple<int, int, int, int> partition_key(const BoardRecordInfo &info)
+    {
+        return std::make_tuple(info.mDifficulty, info.mWordLength, info.mDudCount, info.mSolveScore);
+    }
+
+    std::tuple<int, int, int, int> partition_key(const LibraryPartition &partition)
+    {
+        return std::make_tuple(partition.mDifficulty, partition.mWordLength, partition.mDudCount, partition.mSolveScore);
+    }
+}
+
+//========================================================================
+BoardLibrary::BoardLibrary():
+    mMap(MAP_FAILED),
+    mMapSize(0),
+    mHeader(nullptr),
+    mPartitions(nullptr),
+    mRecords(nullptr),
+    mDifficultyFirst(),
+    mDifficultyCount()
+{
+}
+
+BoardLibrary::~BoardLibrary()
+{
+    if (mMap != MAP_FAILED)
+        munmap(mMap, mMapSize);
+}
+
+bool BoardLibrary::open(const std::string &filename)
+{
+    int fd(::open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if ((fstat(fd, &info) < 0) || (size_t(info.st_size) < sizeof(LibraryHeader)))
+    {
+        std::cerr << "\"" << filename << "\" is not a board library" << std::endl;
+        close(fd);
+        return false;
+    }
+
+    mMapSize = info.st_size;
+    mMap = mmap(nullptr, mMapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mMap == MAP_FAILED)
+    {
+        std::cerr << "Unable to map \"" << filename << "\"" << std::endl;
+        return false;
+    }
+    madvise(mMap, mMapSize, MADV_RANDOM);
+
+    const char *base(static_cast<const char *>(mMap));
+    const LibraryHeader *header(reinterpret_cast<const LibraryHeader *>(base));
+
+    // Every size comes from the file, so the arithmetic on them has to
+    // hold for any value.  Field sizes are bounded far below overflow.
+    bool valid(!memcmp(header->mMagic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) &&
+        (header->mVersion == LibraryHeader::sVersion) &&
+        (header->mFields <= 4) && (header->mWidth <= 255) && (header->mHeight <= 255) &&
+        (header->mRecordSize >= sizeof(BoardRecordInfo) +
+            (uint64_t(header->mFields) * header->mWidth * header->mHeight)) &&
+        !(header->mRecordSize % 8) && !(header->mPartitionOffset % 8) && !(header->mRecordOffset % 8) &&
+        fits_within(header->mPartitionOffset, header->mPartitionCount, sizeof(LibraryPartition), mMapSize) &&
+        fits_within(header->mRecordOffset, header->mBoardCount, header->mRecordSize, mMapSize));
+    if (!valid)
+    {
+        std::cerr << "\"" << filename << "\" is not a compatible board library" << std::endl;
+        return false;
+    }
+
+    mHeader = header;
+    mPartitions = reinterpret_cast<const LibraryPartition *>(base + header->mPartitionOffset);
+    mRecords = base + header->mRecordOffset;
+
+    // A difficulty draws from the span of its partitions, which the
+    // writer keeps contiguous.  Any partition outside the records means
+    // the file can't be trusted.
+    std::array<uint64_t, 3> end{};
+    for (uint64_t i = 0; i < header->mPartitionCount; ++i)
+    {
+        const LibraryPartition &partition(mPartitions[i]);
+        if ((partition.mFirst > header->mBoardCount) || (partition.mCount > header->mBoardCount - partition.mFirst))
+        {
+            std::cerr << "\"" << filename << "\" has a partition outside its boards" << std::endl;
+            mHeader = nullptr;
+            return false;
+        }
+        if ((partition.mDifficulty < 1) || (partition.mDifficulty > 3) || !partition.mCount)
+            continue;
+
+        int difficulty(partition.mDifficulty - 1);
+        if (!end[difficulty] || (partition.mFirst < mDifficultyFirst[difficulty]))
+            mDifficultyFirst[difficulty] = partition.mFirst;
+        end[difficulty] = std::max(end[difficulty], partition.mFirst + partition.mCount);
+    }
+    for (int difficulty = 0; difficulty < 3; ++difficulty)
+    {
+        mDifficultyCount[difficulty] = end[difficulty] ? (end[difficulty] - mDifficultyFirst[difficulty]) : 0;
+    }
+
+    return true;
+}
+
+bool BoardLibrary::matches(int fields, int width, int height) const
+{
+    return mHeader && (int(mHeader->mFields) == fields) &&
+        (int(mHeader->mWidth) == width) && (int(mHeader->mHeight) == height);
+}
+
+BoardLibrary::Board BoardLibrary::getBoard(uint64_t index) const
+{
+    const char *record(mRecords + (index * mHeader->mRecordSize));
+
+    return Board{ reinterpret_cast<const BoardRecordInfo *>(record), record + sizeof(BoardRecordInfo) };
+}
+
+BoardLibrary::Board BoardLibrary::draw(int difficulty, FalloutWords::random_t &random) const
+{
+    if (!mHeader || (difficulty < 1) || (difficulty > 3) || !mDifficultyCount[difficulty - 1])
+        return Board{ nullptr, nullptr };
+
+    uint64_t pick((uint64_t(random()) << 32) | random());
+    return getBoard(mDifficultyFirst[difficulty - 1] + (pick % mDifficultyCount[difficulty - 1]));
+}
+
+//========================================================================
+BoardLibraryWriter::BoardLibraryWriter(int fields, int width, int height):
+    mHeader(),
+    mRecordSize(align8(sizeof(BoardRecordInfo) + size_t(fields) * width * height)),
+    mCount(0),
+    mData()
+{
+    memcpy(mHeader.mMagic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    mHeader.mVersion = LibraryHeader::sVersion;
+    mHeader.mFields = fields;
+    mHeader.mWidth = width;
+    mHeader.mHeight = height;
+    mHeader.mRecordSize = uint32_t(mRecordSize);
+}
+
+void BoardLibraryWriter::resize(uint64_t count)
+{
+    mCount = count;
+    mData.assign(count * mRecordSize, 0);
+}
+
+bool BoardLibraryWriter::write(const std::string &filename)
+{
+    std::vector<uint64_t> order(mCount);
+    for (uint64_t i = 0; i < mCount; ++i)
+    {
+        order[i] = i;
+    }
+
+    auto info_at([this](uint64_t index) -> const BoardRecordInfo & {
+        return *reinterpret_cast<const BoardRecordInfo *>(&mData[index * mRecordSize]);
+    });
+    std::stable_sort(order.begin(), order.end(), [&](uint64_t left, uint64_t right) {
+        return partition_key(info_at(left)) < partition_key(info_at(right));
+    });
+
+    std::vector<LibraryPartition> partitions;
+    for (uint64_t i = 0; i < mCount; ++i)
+    {
+        const BoardRecordInfo &info(info_at(order[i]));
+        if (partitions.empty() || (partition_key(info) != partition_key(partitions.back())))
+        {
+            LibraryPartition partition = {};
+            partition.mDifficulty = info.mDifficulty;
+            partition.mWordLength = info.mWordLength;
+            partition.mDudCount = info.mDudCount;
+            partition.mSolveScore = info.mSolveScore;
+            partition.mFirst = i;
+            partitions.push_back(partition);
+        }
+        ++partitions.back().mCount;
+    }
+
+    mHeader.mBoardCount = mCount;
+    mHeader.mPartitionCount = partitions.size();
+    mHeader.mPartitionOffset = align8(sizeof(LibraryHeader));
+    mHeader.mRecordOffset = align8(mHeader.mPartitionOffset + (partitions.size() * sizeof(LibraryPartition)));
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (file.fail())
+    {
+        std::cerr << "Unable to open \"" << filename << "\" for writing" << std::endl;
+        return false;
+    }
+
+    const char padding[8] = {};
+    file.write(reinterpret_cast<const char *>(&mHeader), sizeof(mHeader));
+    file.write(padding, mHeader.mPartitionOffset - sizeof(mHeader));
+    file.write(reinterpret_cast<const char *>(partitions.data()), partitions.size() * sizeof(LibraryPartition));
+    file.write(padding, mHeader.mRecordOffset - (mHeader.mPartitionOffset + (partitions.size() * sizeof(LibraryPartition))));
+    for (uint64_t index : order)
+    {
+        file.write(&mData[index * mRecordSize], mRecordSize);
+    }
+
+    file.close();
+    if (file.fail())
+    {
+        std::cerr << "Error writing \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    std::cerr << "Wrote " << mCount << " boards in " << partitions.size() << " partitions to \"" <<
+        filename << "\"" << std::endl;
+    return true;
+}
@@ -0,0 +1,136 @@
+/**
+ */
+
+#ifndef FALLOUT_BOARDLIBRARY_H
+#define FALLOUT_BOARDLIBRARY_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gamedata.h"
+
+//========================================================================
+// File layout of a pre-generated board library.  Everything is native
+// endian and 8 byte aligned so the file can be used straight from mmap.
+//
+//   LibraryHeader
+//   LibraryPartition[mPartitionCount]   sorted by key
+//   records[mBoardCount]                grouped by partition
+//
+// A record is a BoardRecordInfo followed by the board's cells, padded
+// to mRecordSize.  Duds are not stored, they follow from the cells.
+struct LibraryHeader
+{
+    static const uint32_t   sVersion = 1;
+
+    char                    mMagic[8];      // "FOBLIB\0\0"
+    uint32_t                mVersion;
+    uint32_t                mFields;
+    uint32_t                mWidth;
+    uint32_t                mHeight;
+    uint32_t                mRecordSize;
+    uint32_t                mReserved;
+    uint64_t                mBoardCount;
+    uint64_t                mPartitionCount;
+    uint64_t                mPartitionOffset;
+    uint64_t                mRecordOffset;
+};
+
+struct LibraryPartition
+{
+    uint8_t                 mDifficulty;    // 1-3
+    uint8_t                 mWordLength;
+    uint8_t                 mDudCount;
+    uint8_t                 mSolveScore;    // expected guesses to solve, in quarters
+    uint32_t                mReserved;
+    uint64_t                mFirst;         // record index
+    uint64_t                mCount;
+};
+
+struct BoardRecordInfo
+{
+    static const size_t     sMaxPasswords = 9;
+
+    uint16_t                mPasswordStart[sMaxPasswords];
+    uint8_t                 mPasswordCount;
+    uint8_t                 mAnswer;        // 0 based
+    uint8_t                 mWordLength;
+    uint8_t                 mDifficulty;
+    uint8_t                 mDudCount;
+    uint8_t                 mSolveScore;
+    uint8_t                 mReserved[2];
+};
+
+//========================================================================
+// A board library mapped read-only.  Boards are drawn uniformly from
+// the partitions matching a difficulty, which are contiguous because
+// difficulty leads the partition key.
+class BoardLibrary
+{
+public:
+    typedef std::shared_ptr<BoardLibrary>   ptr_t;
+
+    struct Board
+    {
+        const BoardRecordInfo * mInfo;
+        const char *            mCells;
+    };
+
+    BoardLibrary();
+    ~BoardLibrary();
+
+    BoardLibrary(const BoardLibrary &) = delete;
+    BoardLibrary &operator=(const BoardLibrary &) = delete;
+
+    bool                    open(const std::string &filename);
+
+    bool                    matches(int fields, int width, int height) const;
+    uint64_t                getBoardCount() const   { return mHeader ? mHeader->mBoardCount : 0; }
+
+    const LibraryPartition *getPartitions() const   { return mPartitions; }
+    uint64_t                getPartitionCount() const { return mHeader ? mHeader->mPartitionCount : 0; }
+
+    Board                   getBoard(uint64_t index) const;
+
+    /// Random board of difficulty 1-3, or one with a null mInfo if the
+    /// library has none.
+    Board                   draw(int difficulty, FalloutWords::random_t &random) const;
+
+private:
+    void *                  mMap;
+    size_t                  mMapSize;
+    const LibraryHeader *   mHeader;
+    const LibraryPartition *mPartitions;
+    const char *            mRecords;
+
+    std::array<uint64_t, 3> mDifficultyFirst;
+    std::array<uint64_t, 3> mDifficultyCount;
+};
+
+//========================================================================
+// Collects generated boards in memory and writes them out sorted into
+// partitions.
+class BoardLibraryWriter
+{
+public:
+    BoardLibraryWriter(int fields, int width, int height);
+
+    size_t                  getRecordSize() const   { return mRecordSize; }
+
+    /// Space for count records, filled in by index from any thread.
+    void                    resize(uint64_t count);
+    char *                  getRecord(uint64_t index) { return &mData[index * mRecordSize]; }
+
+    bool                    write(const std::string &filename);
+
+private:
+    LibraryHeader           mHeader;
+    size_t                  mRecordSize;
+    uint64_t                mCount;
+    std::vector<char>       mData;
+};
+
+#endif // !FALLOUT_BOARDLIBRARY_H
@@ -0,0 +1,107 @@
+/**
+ */
+
+#include "boardscorer.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+//========================================================================
+BoardScore BoardScorer::score(const std::string_view *passwords, size_t count, int duds)
+{
+    BoardScore result = { 0.0, 0, duds };
+
+    count = std::min(count, sMaxPasswords);
+    if (!count)
+        return result;
+
+    // For each guess, the passwords grouped by their likeness to it.  A
+    // guess splits any set of candidates along these same lines.
+    std::array<std::array<uint16_t, sMaxPasswords>, sMaxPasswords> groups;
+    std::array<size_t, sMaxPasswords> group_count;
+    for (size_t guess = 0; guess < count; ++guess)
+    {
+        std::array<int, sMaxPasswords> group_likeness;
+        group_count[guess] = 0;
+
+        for (size_t other = 0; other < count; ++other)
+        {
+            if (other == guess)
+                continue;
+
+            int same(0);
+            for (size_t c = 0; c < passwords[guess].size(); ++c)
+            {
+                same += (passwords[guess][c] == passwords[other][c]);
+            }
+
+            size_t group(0);
+            while ((group < group_count[guess]) && (group_likeness[group] != same))
+                ++group;
+            if (group == group_count[guess])
+            {
+                group_likeness[group] = same;
+                groups[guess][group] = 0;
+                ++group_count[guess];
+            }
+            groups[guess][group] |= uint16_t(1u << other);
+        }
+    }
+
+    // guesses[S] is the total number of guesses, counting the ones that
+    // hit, needed to find each answer in S once the answer is known to
+    // be in S; dividing by |S| gives the expectation.  Keeping the total
+    // makes it an exact integer.  Any password on the board may be
+    // guessed, even one already ruled out, as long as it splits S.
+    const unsigned full((1u << count) - 1);
+    std::array<uint16_t, 1u << sMaxPasswords> guesses;
+    std::array<uint8_t, 1u << sMaxPasswords> worst;
+    guesses[0] = 0;
+    worst[0] = 0;
+
+    for (unsigned set = 1; set <= full; ++set)
+    {
+        int size(__builtin_popcount(set));
+        if (size == 1)
+        {
+            guesses[set] = 1;
+            worst[set] = 1;
+            continue;
+        }
+
+        int best_total(1 << 30);
+        int best_worst(1 << 30);
+
+        for (size_t guess = 0; guess < count; ++guess)
+        {
+            int total(0);
+            int deepest(0);
+            bool splits(true);
+            for (size_t i = 0; i < group_count[guess]; ++i)
+            {
+                unsigned group(groups[guess][i] & set);
+                if (!group)
+                    continue;
+                if (group == set)
+                {   // learns nothing
+                    splits = false;
+                    break;
+                }
+                total += guesses[group];
+                deepest = std::max<int>(deepest, worst[group]);
+            }
+            if (!splits)
+                continue;
+
+            best_total = std::min(best_total, total);
+            best_worst = std::min(best_worst, deepest);
+        }
+
+        guesses[set] = uint16_t(size + best_total);
+        worst[set] = uint8_t(1 + best_worst);
+    }
+
+    result.mExpectedGuesses = double(guesses[full]) / count;
+    result.mWorstCaseGuesses = worst[full];
+    return result;
+}
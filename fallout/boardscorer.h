@@ -0,0 +1,34 @@
+/**
+ */
+
+#ifndef FALLOUT_BOARDSCORER_H
+#define FALLOUT_BOARDSCORER_H
+
+#include <cstddef>
+#include <string_view>
+
+//========================================================================
+// How hard a board is to solve from its passwords alone.
+struct BoardScore
+{
+    double          mExpectedGuesses;   // optimal player, answer uniform
+    int             mWorstCaseGuesses;  // optimal player, worst answer
+    int             mDuds;
+};
+
+//========================================================================
+// Scores a board with an exact dynamic program over the subsets of
+// passwords still in play.  A strict subset always has a smaller mask,
+// so one pass up through the masks has every sub-result ready.  With
+// the game's nine passwords that is 512 states and runs in a few
+// microseconds without touching the heap.
+class BoardScorer
+{
+public:
+    static constexpr size_t sMaxPasswords = 9;
+
+    /// passwords must all be the same length, at most sMaxPasswords.
+    static BoardScore   score(const std::string_view *passwords, size_t count, int duds);
+};
+
+#endif // !FALLOUT_BOARDSCORER_H
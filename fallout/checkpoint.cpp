@@ -0,0 +1,209 @@
+/**
+ */
+
+#include "checkpoint.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//========================================================================
+namespace
+{
+    const char CHECKPOINT_MAGIC[8] = { 'F', 'O', 'C', 'K', 'P', 'T', '\0', '\0' };
+
+    /// Cells padded so the int16_t data after them is aligned.
+    size_t cells_size(int length)
+    {
+        return (size_t(length) + 1) & ~size_t(1);
+    }
+
+    size_t slot_size(int length)
+    {
+        size_t size(sizeof(CheckpointInfo) + cells_size(length) + (length * sizeof(int16_t)) + length);
+        return (size + 7) & ~size_t(7);
+    }
+
+    size_t header_size()
+    {
+        return (sizeof(CheckpointHeader) + 7) & ~size_t(7);
+    }
+
+    uint32_t fnv1a(uint32_t hash, const unsigned char *bytes, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t info_checksum(const CheckpointInfo &info)
+    {
+        CheckpointInfo copy(info);
+        copy.mChecksum = 0;
+        return fnv1a(2166136261u, reinterpret_cast<const unsigned char *>(&copy), sizeof(copy));
+    }
+}
+
+//========================================================================
+SessionCheckpoint::SessionCheckpoint():
+    mFd(-1),
+    mMap(MAP_FAILED),
+    mMapSize(0),
+    mHeader(nullptr),
+    mLength(0),
+    mSlotBoard(),
+    mSlotChecksum()
+{
+}
+
+SessionCheckpoint::~SessionCheckpoint()
+{
+    if (mMap != MAP_FAILED)
+        munmap(mMap, mMapSize);
+    if (mFd >= 0)
+        close(mFd);
+}
+
+bool SessionCheckpoint::open(const std::string &filename, int fields, int width, int height)
+{
+    mFd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (mFd < 0)
+    {
+        std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    if (flock(mFd, LOCK_EX | LOCK_NB) < 0)
+    {
+        std::cerr << "\"" << filename << "\" is in use by another game" << std::endl;
+        return false;
+    }
+
+    mLength = fields * width * height;
+    mMapSize = header_size() + (2 * slot_size(mLength));
+
+    // Anything that is not a checkpoint for this board size is replaced.
+    CheckpointHeader header;
+    bool valid((pread(mFd, &header, sizeof(header), 0) == ssize_t(sizeof(header))) &&
+        !std::memcmp(header.mMagic, CHECKPOINT_MAGIC, sizeof(header.mMagic)) &&
+        (header.mVersion == CheckpointHeader::sVersion) &&
+        (header.mFields == uint32_t(fields)) && (header.mWidth == uint32_t(width)) &&
+        (header.mHeight == uint32_t(height)) && (header.mSlotSize == slot_size(mLength)));
+
+    struct stat info;
+    if (valid && ((fstat(mFd, &info) < 0) || (size_t(info.st_size) != mMapSize)))
+        valid = false;
+
+    if (!valid)
+    {
+        std::memset(static_cast<void *>(&header), 0, sizeof(header));
+        std::memcpy(header.mMagic, CHECKPOINT_MAGIC, sizeof(header.mMagic));
+        header.mVersion = CheckpointHeader::sVersion;
+        header.mFields = fields;
+        header.mWidth = width;
+        header.mHeight = height;
+        header.mSlotSize = slot_size(mLength);
+
+        if ((ftruncate(mFd, 0) < 0) || (ftruncate(mFd, mMapSize) < 0) ||
+            (pwrite(mFd, &header, sizeof(header), 0) != ssize_t(sizeof(header))))
+        {
+            std::cerr << "Unable to initialize \"" << filename << "\"" << std::endl;
+            return false;
+        }
+    }
+
+    mMap = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (mMap == MAP_FAILED)
+    {
+        std::cerr << "Unable to map \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    mHeader = static_cast<CheckpointHeader *>(mMap);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool SessionCheckpoint::load(Slot &slot) const
+{
+    uint64_t commit(mHeader->mCommit.load(std::memory_order_acquire));
+    if (!commit)
+        return false;
+
+    slot = getSlot(int(commit & 1));
+    const CheckpointInfo &info(*slot.mInfo);
+
+    return info.mActive && (info.mSequence == (commit >> 1)) && (info.mChecksum == info_checksum(info)) &&
+        (info.mBoardChecksum == boardChecksum(slot)) &&
+        (info.mPasswordCount <= CheckpointInfo::sMaxPasswords) &&
+        (size_t(info.mPasswordCount) * info.mWordLength <= size_t(mLength));
+}
+
+SessionCheckpoint::Slot SessionCheckpoint::prepare(uint64_t board)
+{
+    uint64_t commit(mHeader->mCommit.load(std::memory_order_relaxed));
+
+    // Slot 0 first, then alternate.
+    int index(commit ? int((commit & 1) ^ 1) : 0);
+
+    Slot slot(getSlot(index));
+    slot.mBoard = board;
+    slot.mBoardCurrent = board && (mSlotBoard[index] == board);
+    return slot;
+}
+
+void SessionCheckpoint::commit(const Slot &slot)
+{
+    uint64_t commit(mHeader->mCommit.load(std::memory_order_relaxed));
+    uint64_t sequence((commit >> 1) + 1);
+    int index(int((reinterpret_cast<char *>(slot.mInfo) - static_cast<char *>(mMap) - header_size()) /
+        slot_size(mLength)));
+
+    if (!slot.mBoardCurrent)
+    {
+        mSlotBoard[index] = slot.mBoard;
+        mSlotChecksum[index] = boardChecksum(slot);
+    }
+
+    slot.mInfo->mSequence = sequence;
+    slot.mInfo->mBoardChecksum = mSlotChecksum[index];
+    slot.mInfo->mChecksum = info_checksum(*slot.mInfo);
+
+    mHeader->mCommit.store((sequence << 1) | uint64_t(index), std::memory_order_release);
+}
+
+void SessionCheckpoint::clear()
+{
+    Slot slot(prepare());
+
+    // An inactive info is never resumed, whatever board is behind it.
+    std::memset(static_cast<void *>(slot.mInfo), 0, sizeof(CheckpointInfo));
+    slot.mBoardCurrent = true;
+    commit(slot);
+}
+
+//------------------------------------------------------------------------
+SessionCheckpoint::Slot SessionCheckpoint::getSlot(int index) const
+{
+    char *base(static_cast<char *>(mMap) + header_size() + (index * slot_size(mLength)));
+
+    Slot slot;
+    slot.mInfo = reinterpret_cast<CheckpointInfo *>(base);
+    slot.mCells = base + sizeof(CheckpointInfo);
+    slot.mData = reinterpret_cast<int16_t *>(slot.mCells + cells_size(mLength));
+    slot.mWords = reinterpret_cast<char *>(slot.mData + mLength);
+    slot.mBoard = 0;
+    slot.mBoardCurrent = false;
+    return slot;
+}
+
+uint32_t SessionCheckpoint::boardChecksum(const Slot &slot) const
+{
+    const unsigned char *bytes(reinterpret_cast<const unsigned char *>(slot.mCells));
+    return fnv1a(2166136261u, bytes, slot_size(mLength) - sizeof(CheckpointInfo));
+}
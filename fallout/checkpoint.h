@@ -0,0 +1,118 @@
+/**
+ */
+
+#ifndef FALLOUT_CHECKPOINT_H
+#define FALLOUT_CHECKPOINT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//========================================================================
+// File layout of a session checkpoint, native endian, used in place
+// through a shared mapping.
+//
+//   CheckpointHeader
+//   two slots of mSlotSize bytes, each a CheckpointInfo followed by
+//   the board's cells padded to an even length, its cell data as
+//   int16_t and the passwords' text, mWordLength bytes each.
+//
+// A checkpoint is written into the slot that is not committed and then
+// published by storing the commit word, so a process dying at any point
+// leaves the previous checkpoint intact.  The page cache keeps what a
+// dead process wrote, nothing is synced.
+//
+// The info and the board after it are checksummed separately.  Most keys
+// only move the cursor, so a slot that already holds the current board
+// has just its info rewritten and hashed; the board is copied and hashed
+// into each slot once after it changes.
+struct CheckpointHeader
+{
+    static const uint32_t   sVersion = 2;
+
+    char                    mMagic[8];      // "FOCKPT\0\0"
+    uint32_t                mVersion;
+    uint32_t                mFields;
+    uint32_t                mWidth;
+    uint32_t                mHeight;
+    uint64_t                mSlotSize;
+    std::atomic<uint64_t>   mCommit;        // sequence * 2 + slot, 0 for none
+};
+
+struct CheckpointInfo
+{
+    static const size_t     sMaxPasswords = 9;
+
+    uint64_t                mSequence;
+    uint32_t                mChecksum;      // FNV-1a of the info with this zeroed
+    uint8_t                 mActive;        // 0 once the board is over
+    uint8_t                 mPasswordCount;
+    uint8_t                 mWordLength;
+    int8_t                  mPasswordIndex;
+    uint16_t                mPasswordStart[sMaxPasswords];
+    uint16_t                mPasswordLive;  // bit per password
+    int32_t                 mTurnsRemaining;
+    int32_t                 mPlayDifficulty;
+    int32_t                 mCursor;
+    int32_t                 mDudCount;
+    uint32_t                mBoardChecksum; // FNV-1a of the rest of the slot
+};
+
+//========================================================================
+// A session checkpoint file mapped read-write.  Saving is a memcpy into
+// the mapping and one atomic store, no system calls.  The file is
+// flocked while open, so two games cannot share one.
+class SessionCheckpoint
+{
+public:
+    typedef std::shared_ptr<SessionCheckpoint>  ptr_t;
+
+    struct Slot
+    {
+        CheckpointInfo *    mInfo;
+        char *              mCells;
+        int16_t *           mData;
+        char *              mWords;
+        uint64_t            mBoard;         // the board version being saved
+        bool                mBoardCurrent;  // cells, data and words already hold it
+    };
+
+    SessionCheckpoint();
+    ~SessionCheckpoint();
+
+    /// Map filename for a board of this size.  A missing file, or one
+    /// for another board size, starts out empty.
+    bool                    open(const std::string &filename, int fields, int width, int height);
+
+    int                     getLength() const   { return mLength; }
+
+    /// The last committed checkpoint if it is intact and a board was in
+    /// progress.
+    bool                    load(Slot &slot) const;
+
+    /// The slot to fill in for the next commit().  board numbers the
+    /// caller's board contents, changing whenever they do, 0 for none.
+    /// Only the info needs filling in when the slot's mBoardCurrent is
+    /// set.
+    Slot                    prepare(uint64_t board = 0);
+    void                    commit(const Slot &slot);
+
+    /// Commit "no board in progress".
+    void                    clear();
+
+private:
+    Slot                    getSlot(int index) const;
+    uint32_t                boardChecksum(const Slot &slot) const;
+
+    int                     mFd;
+    void *                  mMap;
+    size_t                  mMapSize;
+    CheckpointHeader *      mHeader;
+    int                     mLength;
+    uint64_t                mSlotBoard[2];      // board version each slot holds, 0 if unknown
+    uint32_t                mSlotChecksum[2];
+};
+
+#endif // !FALLOUT_CHECKPOINT_H
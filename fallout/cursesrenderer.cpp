@@ -0,0 +1,122 @@
+/**
+ */
+
+#include "cursesrenderer.h"
+#include "tracer.h"
+
+//========================================================================
+class CursesRenderer::CursesPanel : public RenderPanel
+{
+public:
+    CursesPanel(int height, int width, int y, int x, bool scrolling):
+        mWindow(nullptr)
+    {
+        mWindow = newwin(height, width, y, x);
+        if (scrolling)
+            scrollok(mWindow, true);
+    }
+
+    virtual ~CursesPanel()
+    {
+        if (mWindow)
+            delwin(mWindow);
+    }
+
+    virtual int getWidth() const override   { return getmaxx(mWindow); }
+    virtual int getHeight() const override  { return getmaxy(mWindow); }
+
+    virtual void clear() override
+    {
+        wclear(mWindow);
+    }
+
+    virtual void move(int y, int x) override
+    {
+        wmove(mWindow, y, x);
+    }
+
+    virtual void getCursor(int &y, int &x) const override
+    {
+        getyx(mWindow, y, x);
+    }
+
+    virtual void write(const char *text, int length, int attr) override
+    {
+        chtype attributes((attr & ATTR_REVERSE) ? A_REVERSE : A_NORMAL);
+
+        for (int i = 0; i < length; ++i)
+        {
+            waddch(mWindow, static_cast<unsigned char>(text[i]) | attributes);
+        }
+    }
+
+    virtual void clearToEol() override
+    {
+        wclrtoeol(mWindow);
+    }
+
+    virtual void refresh() override
+    {
+        TRACE_SPAN("wnoutrefresh");
+        wnoutrefresh(mWindow);
+    }
+
+private:
+    WINDOW *    mWindow;
+};
+
+//========================================================================
+CursesRenderer::CursesRenderer(FILE *input):
+    mScreen(nullptr),
+    mWindow(nullptr)
+{
+    if (input == stdin)
+    {
+        mWindow = initscr();
+    }
+    else
+    {
+        mScreen = newterm(nullptr, stdout, input);
+        mWindow = stdscr;
+    }
+
+    cbreak();              /* direct input (no newline required)... */
+    noecho();              /* ... without echoing */
+    curs_set(0);           /* hide cursor (if possible) */
+    nodelay(mWindow, TRUE);  /* don't wait for input... */
+    halfdelay(10);         /* ...well, no more than a second, anyway */
+    keypad(mWindow, TRUE);   /* enable cursor keys */
+
+    refresh();
+}
+
+CursesRenderer::~CursesRenderer()
+{
+    endwin();
+    if (mScreen)
+        delscreen(mScreen);
+    mScreen = nullptr;
+    mWindow = nullptr;
+}
+
+//-------------------------------------------------------------------------
+RenderPanel::ptr_t CursesRenderer::createPanel(int height, int width, int y, int x, bool scrolling)
+{
+    return std::make_shared<CursesPanel>(height, width, y, x, scrolling);
+}
+
+void CursesRenderer::flush()
+{
+    TRACE_SPAN("doupdate");
+    doupdate();
+}
+
+void CursesRenderer::beep()
+{
+    ::beep();
+}
+
+int CursesRenderer::readKey()
+{
+    return wgetch(mWindow);
+}
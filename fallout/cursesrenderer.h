@@ -0,0 +1,34 @@
+/**
+ */
+
+#ifndef FALLOUT_CURSESRENDERER_H
+#define FALLOUT_CURSESRENDERER_H
+
+#include <cstdio>
+#include <curses.h>
+
+#include "renderer.h"
+
+//========================================================================
+class CursesRenderer : public Renderer
+{
+public:
+    /// Keys are read from input, which only needs to be given when stdin
+    /// is not the terminal.
+    explicit                CursesRenderer(FILE *input = stdin);
+    virtual                 ~CursesRenderer();
+
+    virtual RenderPanel::ptr_t  createPanel(int height, int width, int y, int x, bool scrolling) override;
+
+    virtual void            flush() override;
+    virtual void            beep() override;
+    virtual int             readKey() override;
+
+private:
+    class CursesPanel;
+
+    SCREEN *                mScreen;
+    WINDOW *                mWindow;
+};
+
+#endif // !FALLOUT_CURSESRENDERER_H
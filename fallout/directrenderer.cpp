@@ -0,0 +1,468 @@
+/**
+ */
+
+#include "directrenderer.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <curses.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+//========================================================================
+namespace
+{
+    const int   DEFAULT_ROWS(24);
+    const int   DEFAULT_COLUMNS(80);
+    const int   KEY_TIMEOUT_MS(1000);   // matches halfdelay(10) on the curses side
+    const int   ESCAPE_TIMEOUT_MS(25);
+    const int   MAX_REWRITE_GAP(4);     // cheaper to reprint than to move
+
+    const char  CSI[] = "\x1b[";
+
+    // Ctrl-C, a hangup or a SIGTERM from loadtest would otherwise kill
+    // the process before the destructor gives the terminal back.  The
+    // handler only uses what is safe in a signal: write, tcsetattr and
+    // re-raising with the default action.
+    const int   RESTORE_SIGNALS[] = { SIGINT, SIGTERM, SIGHUP };
+
+    int             gSignalInFd(-1);
+    int             gSignalOutFd(-1);
+    bool            gSignalRestoreTermios(false);
+    struct termios  gSignalTermios;
+
+    void restore_terminal(int sig)
+    {
+        static const char RESTORE[] = "\x1b[m\x1b[?25h\r\n";
+
+        ssize_t ignored(::write(gSignalOutFd, RESTORE, sizeof(RESTORE) - 1));
+        (void)ignored;
+        if (gSignalRestoreTermios)
+            tcsetattr(gSignalInFd, TCSANOW, &gSignalTermios);
+
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+    }
+}
+
+//========================================================================
+class DirectRenderer::DirectPanel : public RenderPanel
+{
+public:
+    DirectPanel(DirectRenderer *renderer, int height, int width, int y, int x, bool scrolling):
+        mRenderer(renderer),
+        mHeight(height),
+        mWidth(width),
+        mOriginY(y),
+        mOriginX(x),
+        mScrolling(scrolling),
+        mCursorY(0),
+        mCursorX(0)
+    {}
+
+    virtual int getWidth() const override   { return mWidth; }
+    virtual int getHeight() const override  { return mHeight; }
+
+    virtual void clear() override
+    {
+        for (int y = 0; y < mHeight; ++y)
+        {
+            clearRow(y, 0);
+        }
+        mCursorY = 0;
+        mCursorX = 0;
+    }
+
+    virtual void move(int y, int x) override
+    {
+        mCursorY = std::max(0, std::min(y, mHeight - 1));
+        mCursorX = std::max(0, std::min(x, mWidth - 1));
+    }
+
+    virtual void getCursor(int &y, int &x) const override
+    {
+        y = mCursorY;
+        x = mCursorX;
+    }
+
+    virtual void write(const char *text, int length, int attr) override
+    {
+        for (int i = 0; i < length; ++i)
+        {
+            if (text[i] == '\n')
+            {
+                clearRow(mCursorY, mCursorX);
+                newLine();
+                continue;
+            }
+
+            setCell(mCursorY, mCursorX, text[i], attr);
+            if (++mCursorX >= mWidth)
+            {
+                if ((mCursorY == mHeight - 1) && !mScrolling)
+                {   // like curses, the bottom right corner does not wrap
+                    mCursorX = mWidth - 1;
+                    return;
+                }
+                newLine();
+            }
+        }
+    }
+
+    virtual void clearToEol() override
+    {
+        clearRow(mCursorY, mCursorX);
+    }
+
+    virtual void refresh() override
+    {
+        // Cells go straight into the back buffer, nothing to stage.
+    }
+
+private:
+    void setCell(int y, int x, char ch, int attr)
+    {
+        int screen_y(mOriginY + y);
+        int screen_x(mOriginX + x);
+
+        if (!mRenderer->isOnScreen(screen_y, screen_x))
+            return;
+
+        Cell &cell(mRenderer->cellAt(screen_y, screen_x));
+        cell.mChar = ch;
+        cell.mAttr = static_cast<unsigned char>(attr);
+    }
+
+    void clearRow(int y, int from_x)
+    {
+        for (int x = from_x; x < mWidth; ++x)
+        {
+            setCell(y, x, ' ', ATTR_NORMAL);
+        }
+    }
+
+    void newLine()
+    {
+        mCursorX = 0;
+        if (mCursorY < mHeight - 1)
+        {
+            ++mCursorY;
+            return;
+        }
+
+        if (!mScrolling)
+            return;
+
+        for (int y = 1; y < mHeight; ++y)
+        {
+            for (int x = 0; x < mWidth; ++x)
+            {
+                if (mRenderer->isOnScreen(mOriginY + y, mOriginX + x) &&
+                    mRenderer->isOnScreen(mOriginY + y - 1, mOriginX + x))
+                {
+                    mRenderer->cellAt(mOriginY + y - 1, mOriginX + x) =
+                        mRenderer->cellAt(mOriginY + y, mOriginX + x);
+                }
+            }
+        }
+        clearRow(mHeight - 1, 0);
+    }
+
+    DirectRenderer *    mRenderer;
+    int                 mHeight;
+    int                 mWidth;
+    int                 mOriginY;
+    int                 mOriginX;
+    bool                mScrolling;
+    int                 mCursorY;
+    int                 mCursorX;
+};
+
+//========================================================================
+DirectRenderer::DirectRenderer(int in_fd, int out_fd):
+    mInFd(in_fd),
+    mOutFd(out_fd),
+    mSavedTermios(),
+    mRestoreTermios(false),
+    mRows(DEFAULT_ROWS),
+    mColumns(DEFAULT_COLUMNS),
+    mBack(),
+    mFront(),
+    mOutput(),
+    mCursorY(-1),
+    mCursorX(-1),
+    mAttr(RenderPanel::ATTR_NORMAL),
+    mBytesWritten(0),
+    mFrames(0),
+    mPreviousActions(),
+    mDecoder()
+{
+    if (tcgetattr(mInFd, &mSavedTermios) == 0)
+    {
+        struct termios raw(mSavedTermios);
+
+        raw.c_lflag &= ~(ICANON | ECHO);    /* cbreak, no echo */
+        raw.c_oflag &= ~OPOST;              /* bytes go out exactly as emitted */
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        mRestoreTermios = (tcsetattr(mInFd, TCSANOW, &raw) == 0);
+    }
+    installSignalHandlers();
+
+    struct winsize size;
+    if ((ioctl(mOutFd, TIOCGWINSZ, &size) == 0) && size.ws_row && size.ws_col)
+    {
+        mRows = size.ws_row;
+        mColumns = size.ws_col;
+    }
+
+    Cell blank = { ' ', RenderPanel::ATTR_NORMAL };
+    mBack.assign(mRows * mColumns, blank);
+    mFront.assign(mRows * mColumns, blank);
+
+    // Worst case is every cell with a move and an attribute change.
+    mOutput.reserve(mRows * mColumns * 16);
+
+    // Hide the cursor, reset attributes and start from a blank screen so
+    // the front buffer matches what is displayed.
+    mOutput.append(CSI).append("?25l");
+    mOutput.append(CSI).append("m");
+    mOutput.append(CSI).append("2J");
+    writeOutput();
+}
+
+DirectRenderer::~DirectRenderer()
+{
+    removeSignalHandlers();
+
+    emitAttr(RenderPanel::ATTR_NORMAL);
+    emitMove(mRows - 1, 0);
+    mOutput.append("\r\n");
+    mOutput.append(CSI).append("?25h");
+    writeOutput();
+
+    if (mRestoreTermios)
+        tcsetattr(mInFd, TCSANOW, &mSavedTermios);
+}
+
+//-------------------------------------------------------------------------
+RenderPanel::ptr_t DirectRenderer::createPanel(int height, int width, int y, int x, bool scrolling)
+{
+    return std::make_shared<DirectPanel>(this, height, width, y, x, scrolling);
+}
+
+void DirectRenderer::flush()
+{
+    TRACE_SPAN("flush");
+    for (int y = 0; y < mRows; ++y)
+    {
+        for (int x = 0; x < mColumns; ++x)
+        {
+            size_t index((y * mColumns) + x);
+            const Cell &cell(mBack[index]);
+
+            if (cell == mFront[index])
+                continue;
+
+            emitMove(y, x);
+            emitAttr(cell.mAttr);
+            mOutput.push_back(cell.mChar);
+            mFront[index] = cell;
+
+            // A write into the last column leaves the cursor in a
+            // terminal-specific pending wrap state.
+            if (++mCursorX >= mColumns)
+                mCursorX = -1;
+        }
+    }
+
+    if (!mOutput.empty())
+        ++mFrames;
+    writeOutput();
+}
+
+void DirectRenderer::beep()
+{
+    mOutput.push_back('\a');
+}
+
+int DirectRenderer::readKey()
+{
+    int key(mDecoder.next());
+    if (key != ERR)
+        return key;
+
+    while (true)
+    {
+        struct pollfd fds;
+        fds.fd = mInFd;
+        fds.events = POLLIN;
+        fds.revents = 0;
+
+        int result(poll(&fds, 1, mDecoder.isPending() ? ESCAPE_TIMEOUT_MS : KEY_TIMEOUT_MS));
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return ERR;
+        }
+
+        if (result == 0)
+            return mDecoder.next(true);
+
+        char buffer[32];
+        ssize_t count(read(mInFd, buffer, sizeof(buffer)));
+        if (count <= 0)
+            return ERR;
+
+        mDecoder.push(buffer, count);
+        key = mDecoder.next();
+        if (key != ERR)
+            return key;
+    }
+}
+
+//-------------------------------------------------------------------------
+void DirectRenderer::emitMove(int y, int x)
+{
+    if ((y == mCursorY) && (x == mCursorX))
+        return;
+
+    char absolute[24];
+    int absolute_length;
+    if (x == 0)
+        absolute_length = std::snprintf(absolute, sizeof(absolute), "%s%dH", CSI, y + 1);
+    else
+        absolute_length = std::snprintf(absolute, sizeof(absolute), "%s%d;%dH", CSI, y + 1, x + 1);
+
+    if (mCursorX < 0)
+    {   // position unknown, only an absolute move is safe
+        mOutput.append(absolute, absolute_length);
+        mCursorY = y;
+        mCursorX = x;
+        return;
+    }
+
+    // Build the relative alternative: vertical step, then horizontal
+    // step, reprinting short runs of unchanged cells instead of moving
+    // over them.
+    char relative[48];
+    int relative_length(0);
+    int from_x(mCursorX);
+
+    if (y != mCursorY)
+    {
+        int rows(std::abs(y - mCursorY));
+        char direction((y > mCursorY) ? 'B' : 'A');
+        if (rows == 1)
+            relative_length += std::snprintf(relative + relative_length, sizeof(relative) - relative_length, "%s%c", CSI, direction);
+        else
+            relative_length += std::snprintf(relative + relative_length, sizeof(relative) - relative_length, "%s%d%c", CSI, rows, direction);
+    }
+
+    if ((x < from_x) && (x < 2))
+    {
+        relative[relative_length++] = '\r';
+        from_x = 0;
+    }
+
+    if (x > from_x)
+    {
+        int gap(x - from_x);
+        bool rewrite((y == mCursorY) && (gap <= MAX_REWRITE_GAP));
+
+        for (int i = from_x; rewrite && (i < x); ++i)
+        {
+            rewrite = (mFront[(y * mColumns) + i].mAttr == mAttr);
+        }
+
+        if (rewrite)
+        {   // reprinting what is already there is shorter than a move
+            for (int i = from_x; i < x; ++i)
+            {
+                relative[relative_length++] = mFront[(y * mColumns) + i].mChar;
+            }
+        }
+        else if (gap == 1)
+            relative_length += std::snprintf(relative + relative_length, sizeof(relative) - relative_length, "%sC", CSI);
+        else
+            relative_length += std::snprintf(relative + relative_length, sizeof(relative) - relative_length, "%s%dC", CSI, gap);
+    }
+    else if (x < from_x)
+    {
+        int gap(from_x - x);
+        if (gap == 1)
+            relative[relative_length++] = '\b';
+        else
+            relative_length += std::snprintf(relative + relative_length, sizeof(relative) - relative_length, "%s%dD", CSI, gap);
+    }
+
+    if (relative_length < absolute_length)
+        mOutput.append(relative, relative_length);
+    else
+        mOutput.append(absolute, absolute_length);
+
+    mCursorY = y;
+    mCursorX = x;
+}
+
+void DirectRenderer::emitAttr(unsigned char attr)
+{
+    if (attr == mAttr)
+        return;
+
+    mOutput.append(CSI).append((attr & RenderPanel::ATTR_REVERSE) ? "7m" : "m");
+    mAttr = attr;
+}
+
+void DirectRenderer::writeOutput()
+{
+    size_t offset(0);
+
+    while (offset < mOutput.size())
+    {
+        ssize_t count(::write(mOutFd, mOutput.data() + offset, mOutput.size() - offset));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        offset += count;
+    }
+
+    mBytesWritten += offset;
+    mOutput.clear();
+}
+
+//-------------------------------------------------------------------------
+void DirectRenderer::installSignalHandlers()
+{
+    gSignalInFd = mInFd;
+    gSignalOutFd = mOutFd;
+    gSignalRestoreTermios = mRestoreTermios;
+    gSignalTermios = mSavedTermios;
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = restore_terminal;
+    sigemptyset(&action.sa_mask);
+
+    for (size_t i = 0; i < (sizeof(RESTORE_SIGNALS) / sizeof(RESTORE_SIGNALS[0])); ++i)
+    {
+        sigaction(RESTORE_SIGNALS[i], &action, &mPreviousActions[i]);
+    }
+}
+
+void DirectRenderer::removeSignalHandlers()
+{
+    for (size_t i = 0; i < (sizeof(RESTORE_SIGNALS) / sizeof(RESTORE_SIGNALS[0])); ++i)
+    {
+        sigaction(RESTORE_SIGNALS[i], &mPreviousActions[i], nullptr);
+    }
+}
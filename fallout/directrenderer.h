@@ -0,0 +1,81 @@
+/**
+ */
+
+#ifndef FALLOUT_DIRECTRENDERER_H
+#define FALLOUT_DIRECTRENDERER_H
+
+#include <vector>
+#include <string>
+#include <csignal>
+#include <termios.h>
+
+#include "renderer.h"
+#include "keydecoder.h"
+
+//========================================================================
+// Renders without curses.  Panels draw into a back buffer of cells and
+// flush() diffs it against what the terminal already shows, emitting
+// the fewest cursor moves and attribute changes it can into one output
+// buffer that goes out with a single write(2).
+class DirectRenderer : public Renderer
+{
+public:
+                            DirectRenderer(int in_fd, int out_fd);
+    virtual                 ~DirectRenderer();
+
+    virtual RenderPanel::ptr_t  createPanel(int height, int width, int y, int x, bool scrolling) override;
+
+    virtual void            flush() override;
+    virtual void            beep() override;
+    virtual int             readKey() override;
+
+    size_t                  getBytesWritten() const { return mBytesWritten; }
+    /// Flushes that had something to send.
+    size_t                  getFrames() const       { return mFrames; }
+
+private:
+    class DirectPanel;
+
+    struct Cell
+    {
+        char            mChar;
+        unsigned char   mAttr;
+
+        bool operator==(const Cell &other) const { return (mChar == other.mChar) && (mAttr == other.mAttr); }
+        bool operator!=(const Cell &other) const { return !(*this == other); }
+    };
+
+    Cell &                  cellAt(int y, int x) { return mBack[(y * mColumns) + x]; }
+    bool                    isOnScreen(int y, int x) const
+    {
+        return (y >= 0) && (y < mRows) && (x >= 0) && (x < mColumns);
+    }
+
+    void                    emitMove(int y, int x);
+    void                    emitAttr(unsigned char attr);
+    void                    writeOutput();
+    void                    installSignalHandlers();
+    void                    removeSignalHandlers();
+
+    int                     mInFd;
+    int                     mOutFd;
+    struct termios          mSavedTermios;
+    bool                    mRestoreTermios;
+
+    int                     mRows;
+    int                     mColumns;
+    std::vector<Cell>       mBack;
+    std::vector<Cell>       mFront;
+
+    std::string             mOutput;
+    int                     mCursorY;
+    int                     mCursorX;
+    unsigned char           mAttr;
+    size_t                  mBytesWritten;
+    size_t                  mFrames;
+    struct sigaction        mPreviousActions[3];
+
+    KeyDecoder              mDecoder;
+};
+
+#endif // !FALLOUT_DIRECTRENDERER_H
@@ -0,0 +1,104 @@
+/**
+ */
+
+#include "entityregistry.h"
+
+//========================================================================
+EntityRegistry::EntityRegistry(size_t max_passwords, size_t max_duds, std::pmr::memory_resource *memory):
+    mPasswords(memory),
+    mDuds(memory),
+    mDecoys(memory),
+    mDecoySlot(memory)
+{
+    // Reserve for the worst case so boards never grow these in play.
+    mPasswords.reserve(max_passwords);
+    mDecoySlot.reserve(max_passwords);
+    mDecoys.reserve(max_passwords);
+    mDuds.reserve(max_duds);
+}
+
+void EntityRegistry::clear()
+{
+    mPasswords.clear();
+    mDuds.clear();
+    mDecoys.clear();
+    mDecoySlot.clear();
+}
+
+void EntityRegistry::addPassword(int id, int start, int end)
+{
+    if (size_t(id) > mPasswords.size())
+    {
+        mPasswords.resize(id, Entity{ 0, 0, false });
+        mDecoySlot.resize(id, -1);
+    }
+
+    mPasswords[id - 1] = Entity{ start, end, true };
+    if (mDecoySlot[id - 1] < 0)
+    {
+        mDecoySlot[id - 1] = int(mDecoys.size());
+        mDecoys.push_back(id);
+    }
+}
+
+void EntityRegistry::addDud(int id, int start, int end)
+{
+    if (size_t(-id) > mDuds.size())
+        mDuds.resize(-id, Entity{ 0, 0, false });
+
+    mDuds[-id - 1] = Entity{ start, end, true };
+}
+
+void EntityRegistry::setAnswer(int id)
+{
+    removeDecoy(id);
+}
+
+//------------------------------------------------------------------------
+const EntityRegistry::Entity *EntityRegistry::find(int id) const
+{
+    if ((id > 0) && (size_t(id) <= mPasswords.size()))
+        return &mPasswords[id - 1];
+    if ((id < 0) && (size_t(-id) <= mDuds.size()))
+        return &mDuds[-id - 1];
+    return nullptr;
+}
+
+EntityRegistry::Entity *EntityRegistry::lookup(int id)
+{
+    return const_cast<Entity *>(static_cast<const EntityRegistry *>(this)->find(id));
+}
+
+bool EntityRegistry::isLive(int id) const
+{
+    const Entity *entity(find(id));
+    return entity && entity->mLive;
+}
+
+bool EntityRegistry::remove(int id)
+{
+    Entity *entity(lookup(id));
+    if (!entity || !entity->mLive)
+        return false;
+
+    entity->mLive = false;
+    removeDecoy(id);
+    return true;
+}
+
+void EntityRegistry::removeDecoy(int id)
+{
+    if ((id <= 0) || (size_t(id) > mDecoySlot.size()))
+        return;
+
+    int slot(mDecoySlot[id - 1]);
+    if (slot < 0)
+        return;
+
+    // Swap the last decoy into the hole.
+    int last(mDecoys.back());
+    mDecoys[slot] = last;
+    mDecoySlot[last - 1] = slot;
+    mDecoys.pop_back();
+    mDecoySlot[id - 1] = -1;
+}
@@ -0,0 +1,58 @@
+/**
+ */
+
+#ifndef FALLOUT_ENTITYREGISTRY_H
+#define FALLOUT_ENTITYREGISTRY_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+//========================================================================
+// The selectable things on a board.  Passwords have ids 1..n and duds
+// -1..-n, matching the values GameBoard writes into its cell data.  Each
+// entity keeps its cell span and whether it is still on the board, and
+// the decoys (passwords other than the answer) still standing are kept
+// densely so one can be picked at random in constant time.
+class EntityRegistry
+{
+public:
+    struct Entity
+    {
+        int         mStart;     // first cell
+        int         mEnd;       // one past the last cell
+        bool        mLive;
+    };
+
+    EntityRegistry(size_t max_passwords, size_t max_duds,
+        std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+    void            clear();
+
+    void            addPassword(int id, int start, int end);
+    void            addDud(int id, int start, int end);
+
+    /// The answer stays live but is never offered as a decoy.
+    void            setAnswer(int id);
+
+    const Entity *  find(int id) const;
+    bool            isLive(int id) const;
+
+    /// Take an entity off the board.  Returns false if it was already gone.
+    bool            remove(int id);
+
+    size_t          getDudCount() const         { return mDuds.size(); }
+    size_t          getDecoyCount() const       { return mDecoys.size(); }
+    int             getDecoy(size_t n) const    { return mDecoys[n]; }
+
+private:
+    Entity *        lookup(int id);
+    void            removeDecoy(int id);
+
+    std::pmr::vector<Entity>    mPasswords;     // id 1 is at 0
+    std::pmr::vector<Entity>    mDuds;          // id -1 is at 0
+    std::pmr::vector<int>       mDecoys;
+    std::pmr::vector<int>       mDecoySlot;     // index into mDecoys per password, -1 if none
+};
+
+#endif // !FALLOUT_ENTITYREGISTRY_H
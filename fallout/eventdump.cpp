@@ -0,0 +1,103 @@
+// eventdump.cpp : Converts a fallout --event-log to CSV or JSON.
+//
+
+#include "eventlog.h"
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    namespace bpo = boost::program_options;
+
+    struct DumpOptions
+    {
+        std::string     mLogFile;
+        std::string     mFormat;
+    };
+
+    bool load_options(int argc, char **argv, DumpOptions &dump)
+    {
+        bpo::options_description options("Allowed Options");
+        options.add_options()
+            ("help,H",
+                "Produce this help message")
+            ("log",         bpo::value<std::string>(),
+                "Event log written by fallout --event-log")
+            ("format",      bpo::value<std::string>()->default_value("csv"),
+                "Output format\n"
+                    "\tcsv  = One header line, then one line per event\n"
+                    "\tjson = One JSON object per line");
+
+        bpo::positional_options_description positional;
+        positional.add("log", 1);
+
+        bpo::variables_map vm;
+        try
+        {
+            bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+            bpo::notify(vm);
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << "Bad command line:" << std::endl << e.what() << std::endl;
+            std::cout << options << std::endl;
+            return false;
+        }
+
+        if (vm.count("help") || !vm.count("log"))
+        {
+            std::cout << argv[0] << " [options] LOG" << std::endl <<
+                "Converts a fallout event log to text." << std::endl << std::endl <<
+                options << std::endl;
+            return false;
+        }
+
+        dump.mLogFile = vm["log"].as<std::string>();
+        dump.mFormat = vm["format"].as<std::string>();
+        if ((dump.mFormat != "csv") && (dump.mFormat != "json"))
+        {
+            std::cerr << "Unknown format \"" << dump.mFormat << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    DumpOptions dump;
+    if (!load_options(argc, argv, dump))
+        return -1;
+
+    EventLogHeader header;
+    std::vector<GameEvent> events;
+    if (!EventLog::read(dump.mLogFile, header, events))
+        return -1;
+
+    // Times are written relative to the log, make them absolute.
+    bool csv(dump.mFormat == "csv");
+    if (csv)
+        std::cout << "time_ns,session,type,arg1,arg2" << std::endl;
+
+    for (const GameEvent &event : events)
+    {
+        int64_t time(header.mStartTime + int64_t(event.mTime));
+
+        if (csv)
+        {
+            std::cout << time << ',' << event.mSession << ',' << GameEvent::typeName(event.mType) << ',' <<
+                event.mArg1 << ',' << event.mArg2 << '\n';
+        }
+        else
+        {
+            std::cout << "{\"time_ns\":" << time << ",\"session\":" << event.mSession <<
+                ",\"type\":\"" << GameEvent::typeName(event.mType) << "\",\"arg1\":" << event.mArg1 <<
+                ",\"arg2\":" << event.mArg2 << "}\n";
+        }
+    }
+
+    std::cout.flush();
+    return std::cout.fail() ? -1 : 0;
+}
@@ -0,0 +1,336 @@
+/**
+ */
+
+#include "eventlog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+//========================================================================
+namespace
+{
+    const char EVENTLOG_MAGIC[8] = { 'F', 'O', 'E', 'V', 'L', 'O', 'G', '\0' };
+
+    // How often the writer looks at the rings, a ring fills in no less
+    // than 256 keystrokes so this is far from the limit.
+    const std::chrono::milliseconds DRAIN_INTERVAL(5);
+
+    // Write to the file once this much is buffered, or every drain.
+    const size_t WRITE_THRESHOLD(64 * 1024);
+}
+
+//========================================================================
+const char *GameEvent::typeName(uint8_t type)
+{
+    switch (type)
+    {
+    case KEY:           return "key";
+    case BOARD_START:   return "board_start";
+    case GUESS:         return "guess";
+    case TURN_LOST:     return "turn_lost";
+    case DUD_REMOVED:   return "dud_removed";
+    case DECOY_REMOVED: return "decoy_removed";
+    case TURNS_RESET:   return "turns_reset";
+    case BOARD_END:     return "board_end";
+    case DROPPED:       return "dropped";
+    default:            return "unknown";
+    }
+}
+
+//========================================================================
+EventRing::EventRing(uint32_t session, clock_t::time_point origin):
+    mEvents(),
+    mSession(session),
+    mOrigin(origin),
+    mHead(0),
+    mTail(0),
+    mDropped(0)
+{
+}
+
+bool EventRing::push(GameEvent::Type type, int32_t arg1, int32_t arg2)
+{
+    uint64_t head(mHead.load(std::memory_order_relaxed));
+    if (head - mTail.load(std::memory_order_acquire) >= sCapacity)
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    GameEvent &event(mEvents[head & (sCapacity - 1)]);
+    event.mTime = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - mOrigin).count();
+    event.mSession = mSession;
+    event.mType = type;
+    std::fill(std::begin(event.mReserved), std::end(event.mReserved), 0);
+    event.mArg1 = arg1;
+    event.mArg2 = arg2;
+
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t EventRing::drain(GameEvent *events, size_t count)
+{
+    uint64_t tail(mTail.load(std::memory_order_relaxed));
+    uint64_t head(mHead.load(std::memory_order_acquire));
+
+    size_t taken(std::min<uint64_t>(head - tail, count));
+    for (size_t i = 0; i < taken; ++i)
+    {
+        events[i] = mEvents[(tail + i) & (sCapacity - 1)];
+    }
+
+    mTail.store(tail + taken, std::memory_order_release);
+    return taken;
+}
+
+//========================================================================
+EventLog::EventLog():
+    mFd(-1),
+    mSyncInterval(1000),
+    mOrigin(EventRing::clock_t::now()),
+    mMutex(),
+    mWake(),
+    mNewRings(),
+    mNextSession(0),
+    mStop(false),
+    mRings(),
+    mBuffer(),
+    mFailed(false),
+    mFailedErrno(0),
+    mWritten(0),
+    mDropped(0),
+    mThread()
+{
+}
+
+EventLog::~EventLog()
+{
+    close();
+}
+
+bool EventLog::open(const std::string &filename, std::chrono::milliseconds sync_interval)
+{
+    close();
+
+    mFd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (mFd < 0)
+    {
+        std::cerr << "Unable to open \"" << filename << "\" for writing" << std::endl;
+        return false;
+    }
+
+    EventLogHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.mMagic, EVENTLOG_MAGIC, sizeof(header.mMagic));
+    header.mVersion = EventLogHeader::sVersion;
+    header.mStartTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    mOrigin = EventRing::clock_t::now();
+    mSyncInterval = sync_interval;
+    mStop = false;
+    mFailed = false;
+    mFailedErrno = 0;
+    mBuffer.reserve(WRITE_THRESHOLD * 2);
+    mBuffer.assign(reinterpret_cast<const char *>(&header), reinterpret_cast<const char *>(&header) + sizeof(header));
+    if (!flush())
+    {
+        std::cerr << "Error writing \"" << filename << "\": " << std::strerror(mFailedErrno) << std::endl;
+        mFailedErrno = 0;
+        ::close(mFd);
+        mFd = -1;
+        return false;
+    }
+
+    mThread = std::thread(&EventLog::writer, this);
+    return true;
+}
+
+void EventLog::close()
+{
+    if (mThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWake.notify_one();
+        mThread.join();
+    }
+
+    if (mFailedErrno)
+    {
+        std::cerr << "Event log write failed: " << std::strerror(mFailedErrno) << std::endl;
+        mFailedErrno = 0;
+    }
+
+    if (mFd >= 0)
+    {
+        ::fsync(mFd);
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+EventRing::ptr_t EventLog::createRing()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    EventRing::ptr_t ring(std::make_shared<EventRing>(mNextSession++, mOrigin));
+    mNewRings.push_back(ring);
+    return ring;
+}
+
+void EventLog::writer()
+{
+    EventRing::clock_t::time_point last_sync(EventRing::clock_t::now());
+    bool dirty(false);
+
+    while (true)
+    {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait_for(lock, DRAIN_INTERVAL, [this] { return mStop; });
+            stop = mStop;
+            mRings.insert(mRings.end(), mNewRings.begin(), mNewRings.end());
+            mNewRings.clear();
+        }
+
+        drainRings();
+        dirty = dirty || !mBuffer.empty();
+        flush();
+
+        EventRing::clock_t::time_point now(EventRing::clock_t::now());
+        if (dirty && (stop || (now - last_sync >= mSyncInterval)))
+        {
+            ::fdatasync(mFd);
+            last_sync = now;
+            dirty = false;
+        }
+
+        if (stop)
+            break;
+    }
+}
+
+void EventLog::drainRings()
+{
+    std::array<GameEvent, 64> events;
+
+    for (size_t i = 0; i < mRings.size(); )
+    {
+        EventRing &ring(*mRings[i]);
+        bool released(mRings[i].use_count() == 1);
+
+        size_t count;
+        while ((count = ring.drain(events.data(), events.size())) > 0)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                append(events[j]);
+            }
+            if (mBuffer.size() >= WRITE_THRESHOLD)
+                flush();
+        }
+
+        uint64_t dropped(ring.takeDropped());
+        if (dropped)
+        {
+            GameEvent event{};
+            event.mTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                EventRing::clock_t::now() - mOrigin).count();
+            event.mSession = ring.getSession();
+            event.mType = GameEvent::DROPPED;
+            event.mArg1 = int32_t(std::min<uint64_t>(dropped, INT32_MAX));
+            append(event);
+            mDropped += dropped;
+        }
+
+        // Checked before draining, so nothing can have been pushed since.
+        if (released)
+        {
+            std::swap(mRings[i], mRings.back());
+            mRings.pop_back();
+        }
+        else
+            ++i;
+    }
+}
+
+void EventLog::append(const GameEvent &event)
+{
+    const char *bytes(reinterpret_cast<const char *>(&event));
+
+    mBuffer.push_back(char(sizeof(GameEvent)));
+    mBuffer.insert(mBuffer.end(), bytes, bytes + sizeof(GameEvent));
+    ++mWritten;
+}
+
+bool EventLog::flush()
+{
+    const char *data(mBuffer.data());
+    size_t remaining(mBuffer.size());
+
+    while (remaining && !mFailed)
+    {
+        ssize_t written(::write(mFd, data, remaining));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            mFailedErrno = errno;
+            mFailed = true;
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+
+    mBuffer.clear();
+    return !mFailed;
+}
+
+//------------------------------------------------------------------------
+bool EventLog::read(const std::string &filename, EventLogHeader &header, std::vector<GameEvent> &events)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (file.fail())
+    {
+        std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        (std::memcmp(header.mMagic, EVENTLOG_MAGIC, sizeof(header.mMagic)) != 0) ||
+        (header.mVersion != EventLogHeader::sVersion))
+    {
+        std::cerr << "\"" << filename << "\" is not an event log" << std::endl;
+        return false;
+    }
+
+    char record[256];
+    while (true)
+    {
+        int length(file.get());
+        if (length == std::char_traits<char>::eof())
+            break;
+
+        if (!file.read(record, length))
+        {   // the writer was killed mid record, keep what came before
+            std::cerr << "\"" << filename << "\" ends in a partial record" << std::endl;
+            break;
+        }
+
+        GameEvent event{};
+        std::memcpy(&event, record, std::min<size_t>(length, sizeof(event)));
+        events.push_back(event);
+    }
+
+    return true;
+}
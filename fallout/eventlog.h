@@ -0,0 +1,151 @@
+/**
+ */
+
+#ifndef FALLOUT_EVENTLOG_H
+#define FALLOUT_EVENTLOG_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//========================================================================
+// File layout of a game event log, native endian.
+//
+//   EventLogHeader
+//   records, each a uint8_t length followed by that many bytes of a
+//   GameEvent.  Fields are only ever added at the end, so a reader takes
+//   the prefix it knows and skips the rest.
+struct EventLogHeader
+{
+    static const uint32_t   sVersion = 1;
+
+    char                    mMagic[8];      // "FOEVLOG\0"
+    uint32_t                mVersion;
+    uint32_t                mReserved;
+    int64_t                 mStartTime;     // wall clock at open, ns since the epoch
+};
+
+struct GameEvent
+{
+    enum Type : uint8_t
+    {
+        KEY = 1,            // key code
+        BOARD_START,        // difficulty, password count
+        GUESS,              // password id, likeness
+        TURN_LOST,          // turns remaining
+        DUD_REMOVED,        // dud id
+        DECOY_REMOVED,      // password id
+        TURNS_RESET,        // turns remaining
+        BOARD_END,          // won, turns remaining
+        DROPPED             // events lost because the ring was full
+    };
+
+    uint64_t                mTime;          // ns since the log was opened
+    uint32_t                mSession;
+    uint8_t                 mType;
+    uint8_t                 mReserved[3];
+    int32_t                 mArg1;
+    int32_t                 mArg2;
+
+    static const char *     typeName(uint8_t type);
+};
+
+//========================================================================
+// One session's events on their way to the log.  Single producer (the
+// thread playing the session) and single consumer (the log writer), no
+// locks.  A full ring drops the event and counts it rather than make
+// the player wait.
+class EventRing
+{
+public:
+    typedef std::shared_ptr<EventRing>  ptr_t;
+    typedef std::chrono::steady_clock   clock_t;
+
+    EventRing(uint32_t session, clock_t::time_point origin);
+
+    uint32_t                getSession() const  { return mSession; }
+
+    /// Producer side.  Returns false if the event was dropped.
+    bool                    push(GameEvent::Type type, int32_t arg1 = 0, int32_t arg2 = 0);
+
+    /// Consumer side, copies out up to count events.
+    size_t                  drain(GameEvent *events, size_t count);
+    uint64_t                takeDropped()       { return mDropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t sCapacity = 256;    // power of two
+
+    std::array<GameEvent, sCapacity>    mEvents;
+    uint32_t                mSession;
+    clock_t::time_point     mOrigin;
+
+    alignas(64) std::atomic<uint64_t>   mHead;  // next write, producer owned
+    alignas(64) std::atomic<uint64_t>   mTail;  // next read, consumer owned
+    std::atomic<uint64_t>   mDropped;
+};
+
+//========================================================================
+// Appends the events of every ring it hands out to a file from a
+// background thread, so nothing on the input path waits on the disk.
+// The file is fsynced at most once per sync interval.
+class EventLog
+{
+public:
+    typedef std::shared_ptr<EventLog>   ptr_t;
+
+    EventLog();
+    ~EventLog();
+
+    bool                    open(const std::string &filename,
+                                std::chrono::milliseconds sync_interval = std::chrono::milliseconds(1000));
+
+    /// Drain what is left, sync and stop the writer.  A write that failed
+    /// during the run is reported here, once the game has let go of the
+    /// terminal.
+    void                    close();
+
+    /// A ring for a new session, safe from any thread.  The writer lets
+    /// go of it once the caller has and it is empty.
+    EventRing::ptr_t        createRing();
+
+    uint64_t                getWritten() const  { return mWritten; }
+    uint64_t                getDropped() const  { return mDropped; }
+
+    /// Read a whole log back, for the offline tools.
+    static bool             read(const std::string &filename, EventLogHeader &header, std::vector<GameEvent> &events);
+
+private:
+    void                    writer();
+    void                    drainRings();
+    void                    append(const GameEvent &event);
+    bool                    flush();
+
+    int                     mFd;
+    std::chrono::milliseconds   mSyncInterval;
+    EventRing::clock_t::time_point  mOrigin;
+
+    std::mutex              mMutex;
+    std::condition_variable mWake;
+    std::vector<EventRing::ptr_t>   mNewRings;  // guarded by mMutex
+    uint32_t                mNextSession;       // guarded by mMutex
+    bool                    mStop;              // guarded by mMutex
+
+    // writer thread only
+    std::vector<EventRing::ptr_t>   mRings;
+    std::vector<char>       mBuffer;
+    bool                    mFailed;
+    int                     mFailedErrno;       // read by close() after the join
+
+    std::atomic<uint64_t>   mWritten;
+    std::atomic<uint64_t>   mDropped;
+    std::thread             mThread;
+};
+
+#endif // !FALLOUT_EVENTLOG_H
@@ -4,35 +4,70 @@
 #include "fallout.h"
 #include "gamedata.h"
 #include "gameboard.h"
+#include "wordlibrary.h"
+#include "cursesrenderer.h"
+#include "directrenderer.h"
+#include "automation.h"
+#include "boardlibrary.h"
+#include "eventlog.h"
+#include "sharedstats.h"
+#include "checkpoint.h"
+#include "tracer.h"
 #include <boost/program_options.hpp>
-#include <time.h>
-
-WINDOW *gWindow(nullptr);
+#include <random>
+#include <cstdio>
+#include <unistd.h>
 
 
 namespace
 {
     namespace bpo = boost::program_options;
 
-	void initialize_curses()
-	{
-		gWindow = initscr();
+    Renderer::ptr_t create_renderer(const OptionsData::ptr_t &opts, FILE *input)
+    {
+        if (opts->mRenderer == "direct")
+            return std::make_shared<DirectRenderer>(fileno(input), STDOUT_FILENO);
+
+        return std::make_shared<CursesRenderer>(input);
+    }
 
-        cbreak();              /* direct input (no newline required)... */
-        noecho();              /* ... without echoing */
-        curs_set(0);           /* hide cursor (if possible) */
-        nodelay(gWindow, TRUE);  /* don't wait for input... */
-        halfdelay(10);         /* ...well, no more than a second, anyway */
-        keypad(gWindow, TRUE);   /* enable cursor keys */
+    // How often the loading screen updates its word count.
+    const std::chrono::milliseconds LOADING_REFRESH(50);
+
+    /// Returns -1 if the dictionary never became playable, otherwise the
+    /// board's difficulty if the player won or 0.
+    template<class BOARD>
+    int play_board(const Renderer::ptr_t &renderer, const InputSource::ptr_t &input,
+        const WordLibrary::ptr_t &library, const BoardLibrary::ptr_t &boards, const EventLog::ptr_t &events,
+        const SharedStats::ptr_t &stats, const SessionCheckpoint::ptr_t &checkpoint,
+        const OptionsData::ptr_t &opts, unsigned int seed,
+        const typename BOARD::geometry_t &geometry)
+    {
+        typename BOARD::ptr_t board(std::make_shared<BOARD>(renderer, input, library, opts, geometry));
+        board->setBoardLibrary(boards);
+        board->setEventLog(events);
+        board->setStats(stats);
+        board->setCheckpoint(checkpoint);
+
+        // The terminal comes up at once, the dictionary may still be
+        // loading behind it.
+        if (!library->snapshot()->isPlayable())
+        {
+            board->beginLoading();
+            while (!library->waitPlayable(LOADING_REFRESH))
+            {
+                board->showLoading(library->getLoadedWords());
+            }
+            if (!library->snapshot()->isPlayable())
+                return -1;
+        }
 
-        std::srand(static_cast<unsigned int>(time(nullptr)));
-	}
+        board->seed(seed);
+        if (!board->playSession())
+            return 0;
 
-	void shutdown_curses()
-	{
-		endwin();
-		gWindow = nullptr;
-	}
+        return board->getPlayDifficulty();
+    }
 
     class OptionsLoader
     {
@@ -46,7 +81,9 @@ namespace
                 ("company",     bpo::value<std::string>()->default_value("RED ROCKET GARAGE"),  
                     "Set company name in terminal")
                 ("wordfile",    bpo::value<std::string>(),  
-                    "Word file")
+                    "Word file, plain, gzip or zstd compressed (- for stdin)")
+                ("watch",
+                    "Reload the word file whenever it changes on disk")
                 ("wordcheck",   
                     "Load word file, display its contents and exit.")
                 ("no-duds",         
@@ -57,7 +94,55 @@ namespace
                     "Execute until win, return error code with.")
                 ("difficulty",   bpo::value<int>()->default_value(0),          
                     "Set difficulty (0-3)\n"
-                        "\t0 = Random");
+                        "\t0 = Random")
+                ("tier-weighting", bpo::value<std::string>()->default_value("uniform"),
+                    "How a word length is picked within a difficulty\n"
+                        "\tuniform = Every length equally likely\n"
+                        "\tsize    = In proportion to the number of words")
+                ("renderer",    bpo::value<std::string>()->default_value("curses"),
+                    "Output backend\n"
+                        "\tcurses = ncurses\n"
+                        "\tdirect = Built in diffing renderer, fewest bytes per frame")
+                ("render-stats",
+                    "Print the output bytes per frame on exit (direct renderer)")
+                ("fields",      bpo::value<int>()->default_value(2),
+                    "Number of side by side fields on the board")
+                ("field-width", bpo::value<int>()->default_value(12),
+                    "Columns in each field")
+                ("field-height", bpo::value<int>()->default_value(17),
+                    "Rows in each field")
+                ("score-band",  bpo::value<std::string>(),
+                    "Regenerate boards until the expected guesses to solve them, "
+                    "played perfectly, is within MIN:MAX (e.g. 2.5:3)")
+                ("board-library", bpo::value<std::string>(),
+                    "Draw boards from a library made by fallout-boardgen")
+                ("seed",        bpo::value<unsigned int>(),
+                    "Seed for board generation")
+                ("record",      bpo::value<std::string>(),
+                    "Append the keys of this session to a script file")
+                ("event-log",   bpo::value<std::string>(),
+                    "Write every key, guess and dud removal to a binary log, see fallout-events")
+                ("checkpoint",  bpo::value<std::string>(),
+                    "Save the board after every key and resume it from there after a restart")
+                ("stats-file",  bpo::value<std::string>(),
+                    "Add game counts to a stats file shared by every fallout on the host")
+                ("stats-dump",
+                    "Print the totals in --stats-file and exit")
+                ("memory-stats",
+                    "Print the live and peak memory of the dictionary and the boards on exit")
+                ("dictionary-budget", bpo::value<unsigned int>()->default_value(0),
+                    "Fail the dictionary load rather than let it use more than this many MB\n"
+                        "\t0 = No limit")
+                ("trace",       bpo::value<std::string>(),
+                    "Write timing spans for every key as Chrome trace JSON, for Perfetto "
+                    "(needs a build with FALLOUT_TRACING)")
+                ("script",      bpo::value<std::vector<std::string> >()->multitoken(),
+                    "Replay script files (- for stdin) headless and report throughput")
+                ("script-threads", bpo::value<int>()->default_value(0),
+                    "Worker threads for --script\n"
+                        "\t0 = One per CPU")
+                ("script-multiplex",
+                    "Replay every --script session at once, all driven from one event loop thread");
         }
 
         OptionsData::ptr_t load(int argc, char **argv)
@@ -91,6 +176,13 @@ namespace
                 opts->mDataFile = vm["wordfile"].as<std::string>();
 
             opts->mCheckOnly = (vm.count("wordcheck") > 0);
+            opts->mWatchWords = (vm.count("watch") > 0);
+            if (opts->mWatchWords && (opts->mDataFile == "-"))
+            {
+                std::cerr << "--watch needs a word file, not stdin" << std::endl;
+                usage(argv[0]);
+                return OptionsData::ptr_t();
+            }
             opts->mPowerups = (vm.count("no-duds") == 0);
 
             if (vm.count("difficulty"))
@@ -104,9 +196,80 @@ namespace
             else
                 opts->mDifficulty = 0;
 
+            opts->mTierWeighting = vm["tier-weighting"].as<std::string>();
+            if ((opts->mTierWeighting != "uniform") && (opts->mTierWeighting != "size"))
+            {
+                std::cerr << "Unknown tier weighting \"" << opts->mTierWeighting << "\"" << std::endl;
+                usage(argv[0]);
+                return OptionsData::ptr_t();
+            }
+
+            opts->mRenderer = vm["renderer"].as<std::string>();
+            if ((opts->mRenderer != "curses") && (opts->mRenderer != "direct"))
+            {
+                std::cerr << "Unknown renderer \"" << opts->mRenderer << "\"" << std::endl;
+                usage(argv[0]);
+                return OptionsData::ptr_t();
+            }
+            opts->mRenderStats = (vm.count("render-stats") != 0);
+
+            opts->mFields = vm["fields"].as<int>();
+            opts->mFieldWidth = vm["field-width"].as<int>();
+            opts->mFieldHeight = vm["field-height"].as<int>();
+            if ((opts->mFields < 1) || (opts->mFields > 4) ||
+                (opts->mFieldWidth < 8) || (opts->mFieldWidth > 40) ||
+                (opts->mFieldHeight < 4) || (opts->mFieldHeight > 60))
+            {
+                std::cerr << "Board must have 1-4 fields of 8-40 columns and 4-60 rows" << std::endl;
+                usage(argv[0]);
+                return OptionsData::ptr_t();
+            }
+
             opts->mSinglePlay = (vm.count("single-play") != 0);
             opts->mPlayUntilWin = (vm.count("single-win") != 0);
 
+            if (vm.count("script"))
+                opts->mScripts = vm["script"].as<std::vector<std::string> >();
+            opts->mHaveScoreBand = (vm.count("score-band") != 0);
+            if (opts->mHaveScoreBand)
+            {
+                std::string band(vm["score-band"].as<std::string>());
+                if ((std::sscanf(band.c_str(), "%lf:%lf", &opts->mScoreMin, &opts->mScoreMax) != 2) ||
+                    (opts->mScoreMin > opts->mScoreMax))
+                {
+                    std::cerr << "Bad score band \"" << band << "\", expected MIN:MAX" << std::endl;
+                    usage(argv[0]);
+                    return OptionsData::ptr_t();
+                }
+            }
+
+            if (vm.count("board-library"))
+                opts->mBoardLibrary = vm["board-library"].as<std::string>();
+            if (vm.count("record"))
+                opts->mRecordFile = vm["record"].as<std::string>();
+            if (vm.count("event-log"))
+                opts->mEventLog = vm["event-log"].as<std::string>();
+            if (vm.count("checkpoint"))
+                opts->mCheckpointFile = vm["checkpoint"].as<std::string>();
+            if (vm.count("stats-file"))
+                opts->mStatsFile = vm["stats-file"].as<std::string>();
+            if (vm.count("trace"))
+                opts->mTraceFile = vm["trace"].as<std::string>();
+            opts->mMemoryStats = (vm.count("memory-stats") != 0);
+            opts->mDictionaryBudget = vm["dictionary-budget"].as<unsigned int>();
+            opts->mStatsDump = (vm.count("stats-dump") != 0);
+            if (opts->mStatsDump && opts->mStatsFile.empty())
+            {
+                std::cerr << "--stats-dump needs --stats-file" << std::endl;
+                usage(argv[0]);
+                return OptionsData::ptr_t();
+            }
+            opts->mScriptThreads = vm["script-threads"].as<int>();
+            opts->mScriptMultiplex = (vm.count("script-multiplex") != 0);
+
+            opts->mHaveSeed = (vm.count("seed") != 0);
+            opts->mSeed = opts->mHaveSeed ? vm["seed"].as<unsigned int>() : 0;
+
             return opts;
         }
 
@@ -134,55 +297,185 @@ int main(int argc, char **argv)
             return -1;
     }
 
+    if (opts->mStatsDump)
+        return SharedStats::dump(opts->mStatsFile, std::cout) ? 0 : -1;
+
+    if (opts->mDictionaryBudget)
+        FalloutWords::getMemory().setBudget(size_t(opts->mDictionaryBudget) << 20);
 
-    FalloutWords::ptr_t words(std::make_shared<FalloutWords>());
+    FalloutWords::ptr_t words(std::make_shared<FalloutWords>((opts->mTierWeighting == "size") ?
+        FalloutWords::WEIGHT_SIZE : FalloutWords::WEIGHT_UNIFORM));
 
-    if (!words->loadWordList(opts->mDataFile))
+    // The game loads its dictionary behind the loading screen, stdin
+    // has to be read before curses takes the terminal.
+    bool background_load(!opts->mCheckOnly && opts->mScripts.empty() && (opts->mDataFile != "-"));
+    if (!background_load)
     {
-        return -1;
+        if (!words->loadWordList(opts->mDataFile))
+        {
+            return -1;
+        }
+
+        if (!words->isPlayable() && !opts->mCheckOnly)
+        {
+            std::cerr << "Not enough words to play, need 10 or more words of at least one length" << std::endl;
+            return -1;
+        }
+
+        if (opts->mCheckOnly)
+        {
+            words->dump();
+            if (opts->mMemoryStats)
+                MemoryAccount::report(std::cout);
+            return -1;
+        }
     }
 
-    if (opts->mCheckOnly)
+    BoardLibrary::ptr_t boards;
+    if (!opts->mBoardLibrary.empty())
     {
-        words->dump();
-        return -1;
+        boards = std::make_shared<BoardLibrary>();
+        if (!boards->open(opts->mBoardLibrary))
+            return -1;
     }
 
-	initialize_curses();
+    EventLog::ptr_t events;
+    if (!opts->mEventLog.empty())
+    {
+        events = std::make_shared<EventLog>();
+        if (!events->open(opts->mEventLog))
+            return -1;
+    }
 
-    GameBoard::ptr_t board = std::make_shared<GameBoard>(gWindow, words, opts);
-    int played_difficulty(0);
-    bool win(false);
+    SharedStats::ptr_t stats;
+    if (!opts->mStatsFile.empty())
+    {
+        stats = std::make_shared<SharedStats>();
+        if (!stats->open(opts->mStatsFile))
+            return -1;
+    }
 
-    while(true)
+    if (!opts->mTraceFile.empty() && !Tracer::enable(opts->mTraceFile))
     {
-        board->initialize();
-        win = board->play();
+        std::cerr << "--trace needs a build with -DFALLOUT_TRACING=ON" << std::endl;
+        return -1;
+    }
 
-        played_difficulty = board->getPlayDifficulty();
+    if (!opts->mScripts.empty())
+    {
+        ScriptRunner runner(std::make_shared<WordLibrary>(words), opts);
+        runner.setBoardLibrary(boards);
+        runner.setEventLog(events);
+        runner.setStats(stats);
 
-        if (opts->mSinglePlay || (win && opts->mPlayUntilWin))
-            break;
+        if (!runner.loadScripts())
+            return -1;
+        int result(runner.run());
+        Tracer::write();
+        if (opts->mMemoryStats)
+            MemoryAccount::report(std::cout);
 
-        board->writeStatus("\nPLAY AGAIN? [Y/N]");
-        int ch;
-        while(true)
+        if (events)
         {
-            ch = getch();
-            if ((ch == 'Y') || (ch == 'y') || (ch == 'N') || (ch == 'n'))
-                break;
-            if (ch)
-                beep(); 
+            events->close();
+            std::cerr << "Logged " << events->getWritten() << " events, " <<
+                events->getDropped() << " dropped." << std::endl;
         }
+        return result;
+    }
+
+    WordLibrary::ptr_t library(std::make_shared<WordLibrary>(words));
+    words.reset();
+
+    if (background_load)
+        library->startLoading(opts->mDataFile, opts->mDifficulty);
 
-        if ((ch == 'N') || (ch == 'n'))
-            break;
+    if (opts->mWatchWords && !library->watch(opts->mDataFile))
+        return -1;
+
+    SessionCheckpoint::ptr_t checkpoint;
+    if (!opts->mCheckpointFile.empty())
+    {
+        checkpoint = std::make_shared<SessionCheckpoint>();
+        if (!checkpoint->open(opts->mCheckpointFile, opts->mFields, opts->mFieldWidth, opts->mFieldHeight))
+            return -1;
     }
 
-    board.reset();
-	shutdown_curses();
-    if (win)
-        return played_difficulty;
+    unsigned int seed(opts->mHaveSeed ? opts->mSeed : std::random_device()());
+
+    // With the words piped in on stdin, the keys have to come from the
+    // terminal itself.
+    FILE *keyboard(stdin);
+    if (opts->mDataFile == "-")
+    {
+        keyboard = std::fopen("/dev/tty", "r");
+        if (!keyboard)
+        {
+            std::cerr << "Words read from stdin, but there is no terminal to play on" << std::endl;
+            return -1;
+        }
+    }
+
+    Renderer::ptr_t renderer(create_renderer(opts, keyboard));
+    InputSource::ptr_t input(std::make_shared<TerminalInput>(renderer));
+
+    if (!opts->mRecordFile.empty())
+    {
+        std::shared_ptr<RecordingInput> recorder(std::make_shared<RecordingInput>(input));
+        if (!recorder->open(opts->mRecordFile, seed))
+            return -1;
+        input = recorder;
+    }
+
+    int result(0);
+
+    if (is_standard_geometry(*opts))
+        result = play_board<GameBoard>(renderer, input, library, boards, events, stats, checkpoint, opts, seed,
+            StandardGeometry());
+    else
+        result = play_board<RuntimeGameBoard>(renderer, input, library, boards, events, stats, checkpoint, opts, seed,
+            runtime_geometry(*opts));
+
+    size_t bytes_written(0);
+    size_t frames(0);
+    if (std::shared_ptr<DirectRenderer> direct = std::dynamic_pointer_cast<DirectRenderer>(renderer))
+    {
+        bytes_written = direct->getBytesWritten();
+        frames = direct->getFrames();
+    }
+
+    // The input holds on to the renderer, both have to go to give the
+    // terminal back.
+    input.reset();
+    renderer.reset();
+    if (keyboard != stdin)
+        std::fclose(keyboard);
+    library->cancelLoading();
+    library->stopWatching();
+    if (!library->getWatchError().empty())
+        std::cerr << library->getWatchError() << std::endl;
+    if (events)
+        events->close();
+    Tracer::write();
+
+    if (background_load && FalloutWords::getMemory().getRefused())
+    {
+        std::cerr << "Stopped loading \"" << opts->mDataFile << "\" at its " << opts->mDictionaryBudget <<
+            " MB budget" << std::endl;
+    }
+    if (opts->mMemoryStats)
+        MemoryAccount::report(std::cout);
+    if (opts->mRenderStats && frames)
+    {
+        std::cout << "Wrote " << bytes_written << " bytes in " << frames << " frames, " <<
+            (bytes_written / frames) << " bytes per frame" << std::endl;
+    }
+
+    if (result < 0)
+    {
+        std::cerr << "Unable to load a playable dictionary from \"" << opts->mDataFile << "\"" << std::endl;
+        return -1;
+    }
 
-	return 0;
+	return result;
 }
@@ -6,7 +6,8 @@
 #include <iostream>
 #include <memory>
 #include <algorithm>
-#include <curses.h>
+#include <string>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -17,11 +18,36 @@ struct OptionsData
 
     std::string     mTerminalName;
     std::string     mDataFile;
+    std::string     mRenderer;
+    bool            mRenderStats;
+    std::string     mTierWeighting;
     int             mDifficulty;
     bool            mPowerups;
     bool            mCheckOnly;
     bool            mSinglePlay;
     bool            mPlayUntilWin;
-};
+    bool            mWatchWords;
+
+    int             mFields;
+    int             mFieldWidth;
+    int             mFieldHeight;
 
-extern WINDOW *gWindow;
+    std::string     mBoardLibrary;
+
+    std::vector<std::string> mScripts;
+    std::string     mRecordFile;
+    std::string     mEventLog;
+    std::string     mStatsFile;
+    std::string     mCheckpointFile;
+    std::string     mTraceFile;
+    bool            mMemoryStats;
+    unsigned int    mDictionaryBudget;  // MB, 0 for none
+    bool            mStatsDump;
+    int             mScriptThreads;
+    bool            mScriptMultiplex;
+    bool            mHaveScoreBand;
+    double          mScoreMin;
+    double          mScoreMax;
+    bool            mHaveSeed;
+    unsigned int    mSeed;
+};
@@ -0,0 +1,90 @@
+/**
+ */
+
+#include "fillergenerator.h"
+#include <cstring>
+
+namespace
+{
+    uint64_t splitmix64(uint64_t &state)
+    {
+        uint64_t z(state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+}
+
+//========================================================================
+FillerGenerator::FillerGenerator(std::string_view alphabet):
+    mTable(),
+    mLimit(256 - (256 % alphabet.size())),
+    mState0(),
+    mState1(),
+    mBlock(),
+    mBlockPos(sBlockSize)
+{
+    for (unsigned i = 0; i < mTable.size(); ++i)
+    {
+        mTable[i] = alphabet[i % alphabet.size()];
+    }
+
+    FalloutWords::random_t random;
+    seed(random);
+}
+
+void FillerGenerator::seed(FalloutWords::random_t &random)
+{
+    uint64_t state((uint64_t(random()) << 32) | random());
+
+    for (int lane = 0; lane < sLanes; ++lane)
+    {   // splitmix never yields an all zero pair from distinct inputs
+        mState0[lane] = splitmix64(state);
+        mState1[lane] = splitmix64(state);
+    }
+    mBlockPos = sBlockSize;
+}
+
+//------------------------------------------------------------------------
+void FillerGenerator::fill(char *out, size_t count)
+{
+    size_t written(0);
+
+    while (written < count)
+    {
+        if (mBlockPos >= sBlockSize)
+            refill();
+
+        size_t pos(mBlockPos);
+        while ((pos < sBlockSize) && (written < count))
+        {
+            uint8_t byte(mBlock[pos++]);
+            out[written] = mTable[byte];
+            written += (byte < mLimit);     // rejected bytes are overwritten
+        }
+        mBlockPos = pos;
+    }
+}
+
+void FillerGenerator::refill()
+{
+    const size_t step(sLanes * sizeof(uint64_t));
+
+    for (size_t offset = 0; offset < sBlockSize; offset += step)
+    {
+        uint64_t values[sLanes];
+
+        for (int lane = 0; lane < sLanes; ++lane)
+        {
+            uint64_t x(mState0[lane]);
+            uint64_t y(mState1[lane]);
+
+            mState0[lane] = y;
+            x ^= x << 23;
+            mState1[lane] = x ^ y ^ (x >> 17) ^ (y >> 26);
+            values[lane] = mState1[lane] + y;
+        }
+        std::memcpy(mBlock.data() + offset, values, step);
+    }
+    mBlockPos = 0;
+}
@@ -0,0 +1,46 @@
+/**
+ */
+
+#ifndef FALLOUT_FILLERGENERATOR_H
+#define FALLOUT_FILLERGENERATOR_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "gamedata.h"
+
+//========================================================================
+// Fills board cells with junk characters.  Random bytes come a block at
+// a time from four interleaved xorshift128+ lanes, which the compiler
+// can keep in vector registers, and go through a 256 entry table into
+// the filler alphabet.  Bytes past the last whole multiple of the
+// alphabet size are rejected, so every character keeps exactly its
+// weight in the alphabet with no modulo bias.
+class FillerGenerator
+{
+public:
+    explicit FillerGenerator(std::string_view alphabet);
+
+    /// Reseed from the board generator so boards stay reproducible.
+    void                seed(FalloutWords::random_t &random);
+
+    void                fill(char *out, size_t count);
+
+private:
+    static const int    sLanes = 4;
+    static const size_t sBlockSize = 256;
+
+    void                refill();
+
+    std::array<char, 256>       mTable;
+    unsigned                    mLimit;     // bytes >= this are rejected
+
+    std::array<uint64_t, sLanes> mState0;
+    std::array<uint64_t, sLanes> mState1;
+
+    std::array<uint8_t, sBlockSize> mBlock;
+    size_t                      mBlockPos;
+};
+
+#endif // !FALLOUT_FILLERGENERATOR_H
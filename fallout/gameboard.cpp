@@ -3,8 +3,11 @@
 
 #include "fallout.h"
 #include "gameboard.h"
+#include "tracer.h"
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
+#include <curses.h>
 
 //========================================================================
 namespace
@@ -15,13 +18,36 @@ namespace
     //const std::string FILLER_CHARS("\\/!@#$%^'\",.-_&*(){}[]<>");
     const std::string FILLER_CHARS("\\\\//!!@@##$$%%^^''\"\",--_&&*((){{}[[]<<>");
     const std::string CLOSING_CHARS(")}]>");
-    std::map<char, char> MATCHING_BRACE({
+    const std::map<char, char> MATCHING_BRACE({
         {')', '('},
         {'}', '{'},
         {']', '['},
         {'>', '<'} });
 
-    int generate_random_addr()
+    const int HEADER_HEIGHT(5);
+    const int ADDRESS_WIDTH(6);
+    const int STATUS_WIDTH(20);
+    const int STATUS_HISTORY(100);  // lines kept for scrolling back
+
+    /// std::string::find_last_of for any contiguous char storage.
+    template<class T>
+    size_t find_last_of(const T &field, std::string_view chars, size_t pos)
+    {
+        if (field.empty())
+            return std::string::npos;
+
+        size_t index(std::min(pos, field.size() - 1));
+        while (true)
+        {
+            if (chars.find(field[index]) != std::string::npos)
+                return index;
+            if (!index)
+                return std::string::npos;
+            --index;
+        }
+    }
+
+    int generate_random_addr(FalloutWords::random_t &random)
     {
         int address(0);
 
@@ -29,9 +55,9 @@ namespace
         {
             address = address << 4;
             if (i == 3)
-                address |= (std::rand() % 2) * 8;
+                address |= (random() % 2) * 8;
             else
-                address |= std::rand() % 0xF;
+                address |= random() % 0xF;
         }
 
         return address;
@@ -39,161 +65,356 @@ namespace
 }
 
 //========================================================================
-const int GameBoard::sFieldWidth(12);
-const int GameBoard::sFieldHeight(17);
-const int GameBoard::sMaxTurns(4);
+template<class GEOMETRY>
+const int BasicGameBoard<GEOMETRY>::sMaxTurns(4);
 
 //------------------------------------------------------------------------
-GameBoard::GameBoard(WINDOW *mainwindow, const FalloutWords::ptr_t &words, 
-        const OptionsData::ptr_t &opts):
-    mGameWindow(mainwindow),
-    mPanelHeader(nullptr),
-    mPanelStatus(nullptr),
-    mPanelFiller({ nullptr, nullptr }),
-    mPanelField({ nullptr, nullptr }),
-    mCompanyName(),
+template<class GEOMETRY>
+BasicGameBoard<GEOMETRY>::BasicGameBoard(const Renderer::ptr_t &renderer, const InputSource::ptr_t &input,
+        const WordLibrary::ptr_t &library, const OptionsData::ptr_t &opts, const GEOMETRY &geometry):
+    mMemory("board"),
+    mGeometry(geometry),
+    mRenderer(renderer),
+    mInput(input),
+    mRandom(),
+    mFiller(FILLER_CHARS),
+    mPanelHeader(),
+    mPanelStatus(),
+    mPanelFiller(),
+    mPanelField(),
+    mStatusHistory(STATUS_WIDTH, STATUS_HISTORY, &mMemory),
+    mCompanyName(&mMemory),
+    mHeaderText(&mMemory),
+    mAttemptText(&mMemory),
+    mGutterText(&mMemory),
+    mHighlightStart(0),
+    mHighlightEnd(0),
     mTurnsRemaining(sMaxTurns),
     mPasswordIndex(-1),
-    mCursor(),
+    mBoardVersion(0),
+    mDisplayField(mGeometry.template makeStorage<char>(&mMemory)),
+    mDisplayData(mGeometry.template makeStorage<int>(&mMemory)),
+    mEntities(sMaxPasswords, mGeometry.getLength() / 2, &mMemory),
+    mCursor(mGeometry, false, mDisplayData, mEntities),
     mExit(false),
     mWin(false),
-    mWords(words),
+    mArenaBuffer(),
+    mArena(mArenaBuffer.data(), mArenaBuffer.size(), &mMemory),
+    mPasswords(&mArena),
+    mLibrary(library),
+    mWords(),
+    mBoardLibrary(),
+    mEvents(),
+    mStats(),
+    mCheckpoint(),
+    mBoardStart(),
     mOpts(opts)
 { 
-    mGameWindow = mainwindow;
+    mMemory.addFixed(sizeof(*this));
+    mCompanyName.assign(opts->mTerminalName);
 
-    mCompanyName = opts->mTerminalName;
+    // Each field is an address gutter, a gap, the field and a gap.
+    int fields(mGeometry.getFields());
+    int width(mGeometry.getWidth());
+    int height(mGeometry.getHeight());
+    int stride(ADDRESS_WIDTH + 1 + width + 1);
 
-    mPanelHeader = newwin(5, 40, 0, 0);
-    mPanelFiller[0] = newwin(17, 6, 5, 0);
-    mPanelFiller[1] = dupwin(mPanelFiller[0]);
-    mvwin(mPanelFiller[1], 5, 20);
-    mPanelField[0] = newwin(sFieldHeight, sFieldWidth, 5, 7);
-    mPanelField[1] = dupwin(mPanelField[0]);
-    mvwin(mPanelField[1], 5, 27);
-    mPanelStatus = newwin(17, 20, 5, 40);
-    scrollok(mPanelStatus, true);
-    immedok(mPanelStatus, true);
-    wmove(mPanelStatus, 16, 0);
-}
-
-GameBoard::~GameBoard()
-{
-    mGameWindow = nullptr;
-
-    if (mPanelHeader)
-        delwin(mPanelHeader);
-    if (mPanelStatus)
-        delwin(mPanelStatus);
-
-    for (WINDOW *filler : mPanelFiller)
+    mPanelHeader = mRenderer->createPanel(HEADER_HEIGHT, fields * stride, 0, 0, false);
+    for (int field = 0; field < fields; ++field)
     {
-		if (filler)
-			delwin(filler);
+        mPanelFiller.push_back(mRenderer->createPanel(height, ADDRESS_WIDTH, HEADER_HEIGHT, field * stride, false));
+        mPanelField.push_back(mRenderer->createPanel(height, width, HEADER_HEIGHT, (field * stride) + ADDRESS_WIDTH + 1, false));
     }
+    mPanelStatus = mRenderer->createPanel(height, STATUS_WIDTH, HEADER_HEIGHT, fields * stride, false);
 
-    for (WINDOW *field : mPanelField)
+    // The header never changes and the attempts line has one form per
+    // turn count, so both are formatted once here and only blitted.
+    mHeaderText.assign(mCompanyName).append(" TERMLINK PROTOCOL\nENTER PASSWORD NOW");
+    for (int turns = 0; turns <= sMaxTurns; ++turns)
     {
-		if (field)
-			delwin(field);
+        std::string line("ATTEMPTS REMAINING: " + std::to_string(turns) + " ");
+        for (int i = 0; i < turns; ++i)
+        {
+            line += "\xDB ";
+        }
+        mAttemptText.emplace_back(line);
     }
+    mGutterText.resize(size_t(height) * ADDRESS_WIDTH);
 }
 
-void GameBoard::initialize()
+template<class GEOMETRY>
+BasicGameBoard<GEOMETRY>::~BasicGameBoard()
+{
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::initialize()
 {
     mTurnsRemaining = 4;
     mWin = false;
     mExit = false;
 
-    wclear(mPanelHeader);
-    wclear(mPanelFiller[0]);
-    wclear(mPanelFiller[1]);
-    wclear(mPanelField[0]);
-    wclear(mPanelField[1]);
-    wclear(mPanelStatus);
+    mPanelHeader->clear();
+    for (const RenderPanel::ptr_t &filler : mPanelFiller)
+    {
+        filler->clear();
+    }
+    for (const RenderPanel::ptr_t &field : mPanelField)
+    {
+        field->clear();
+    }
+    mStatusHistory.startPage();
 
     initializeGameData();
-
-    refresh();
+    ++mBoardVersion;
+    recordEvent(GameEvent::BOARD_START, mPlayDifficulty, int32_t(mPasswords.size()));
 
     displayHeader();
     displayFiller();
     displayField();
     displayStatus();
 
-    if (mPanelStatus)
-        wrefresh(mPanelStatus);
+    mRenderer->flush();
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::beginLoading()
+{
+    mTurnsRemaining = sMaxTurns;
+
+    mPanelHeader->clear();
+    for (const RenderPanel::ptr_t &filler : mPanelFiller)
+    {
+        filler->clear();
+    }
+    for (const RenderPanel::ptr_t &field : mPanelField)
+    {
+        field->clear();
+        field->refresh();
+    }
+    mPanelStatus->clear();
+
+    displayHeader();
+    displayFiller();
+    showLoading(0);
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::showLoading(size_t words)
+{
+    char buffer[STATUS_WIDTH + 1];
+    int length(std::snprintf(buffer, sizeof(buffer), "LOADING %zu", words));
+
+    mPanelStatus->move(mPanelStatus->getHeight() - 1, 0);
+    mPanelStatus->write(buffer, std::min<int>(length, STATUS_WIDTH));
+    mPanelStatus->clearToEol();
+    mPanelStatus->refresh();
+
+    mRenderer->flush();
 }
 
-void GameBoard::setPlayDifficulty(int difficulty)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::setPlayDifficulty(int difficulty)
 {
     if (!difficulty)
-        mPlayDifficulty = (std::rand() % 3) + 1;
+        mPlayDifficulty = (mRandom() % 3) + 1;
     else
         mPlayDifficulty = difficulty;
 }
 
-void GameBoard::initializeGameData()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::initializeGameData()
 {
-    mCursor = std::make_shared<GameCursor>(sFieldWidth, sFieldHeight, false, mDisplayData);
+    // Pick up the latest dictionary, the previous one is released once
+    // no other board is using it.
+    mWords = mLibrary->snapshot();
+
+    mCursor.setPosition(0);
+
+    mGeometry.allocate(mDisplayField);
+    mGeometry.allocate(mDisplayData);
+    std::fill(mDisplayData.begin(), mDisplayData.end(), 0);
+    mEntities.clear();
+
+    // Drop the last board's scratch memory before reusing the arena.
+    mPasswords = password_vec_t(&mArena);
+    mArena.release();
+    mPasswords.reserve(sMaxPasswords);
+
+    // The score only depends on the passwords, so with --score-band
+    // only they are redrawn until one lands inside it, settling for the
+    // last draw if none does.
+    BoardLibrary::Board board{ nullptr, nullptr };
+    for (int attempt = 1; ; ++attempt)
+    {
+        mPasswords.clear();
+        setPlayDifficulty(mOpts->mDifficulty);
+        if (!drawLibraryBoard(board))
+            selectPasswords();
 
-    int total_length(sFieldWidth * sFieldHeight * 2);
-    mDisplayField.clear();
-    
-    mDisplayField.resize(total_length);
+        if (!mOpts->mHaveScoreBand || (attempt >= sMaxScoreAttempts))
+            break;
 
-    for (char &c : mDisplayField)
-    {
-        c = FILLER_CHARS[std::rand() % FILLER_CHARS.size()];
+        double expected(BoardScorer::score(mPasswords.data(), mPasswords.size(), 0).mExpectedGuesses);
+        if ((expected >= mOpts->mScoreMin) && (expected <= mOpts->mScoreMax))
+            break;
     }
 
-    mDisplayData.clear();
-    mDisplayData.resize(total_length, 0);
+    if (board.mInfo)
+    {
+        loadLibraryBoard(board);
+    }
+    else
+    {
+        mFiller.seed(mRandom);
+        mFiller.fill(mDisplayField.data(), mDisplayField.size());
+        placePasswords();
+    }
 
-    setPlayDifficulty(mOpts->mDifficulty);
-    initializeWords();
     if (mOpts->mPowerups)
         initializeDuds();
 }
 
-void GameBoard::initializeWords()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::drawLibraryBoard(BoardLibrary::Board &board)
 {
-    int total_length(sFieldWidth * sFieldHeight * 2);
+    board = BoardLibrary::Board{ nullptr, nullptr };
+    if (!mBoardLibrary ||
+            !mBoardLibrary->matches(mGeometry.getFields(), mGeometry.getWidth(), mGeometry.getHeight()))
+        return false;
 
-    mPasswords.clear();
+    BoardLibrary::Board drawn(mBoardLibrary->draw(mPlayDifficulty, mRandom));
+    if (!drawn.mInfo || !drawn.mInfo->mPasswordCount)
+        return false;
 
-    const FalloutWords::string_set_t &wordset(mWords->selectWordSet(mPlayDifficulty));
-    size_t wordlength(wordset.begin()->length());
+    const BoardRecordInfo &info(*drawn.mInfo);
+    if ((info.mPasswordCount > sMaxPasswords) || (info.mAnswer >= info.mPasswordCount))
+        return false;
+    for (int i = 0; i < int(info.mPasswordCount); ++i)
+    {
+        if (size_t(info.mPasswordStart[i]) + info.mWordLength > mDisplayField.size())
+            return false;
+    }
 
-    FalloutWords::string_vec_t list(wordset.begin(), wordset.end());
+    // The passwords stay views into the mapped record, which lives as
+    // long as the library.
+    for (int i = 0; i < int(info.mPasswordCount); ++i)
+    {
+        mPasswords.emplace_back(drawn.mCells + info.mPasswordStart[i], info.mWordLength);
+    }
+
+    board = drawn;
+    return true;
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::loadLibraryBoard(const BoardLibrary::Board &board)
+{
+    const BoardRecordInfo &info(*board.mInfo);
+
+    std::copy(board.mCells, board.mCells + mDisplayField.size(), mDisplayField.begin());
+    for (int i = 0; i < int(info.mPasswordCount); ++i)
+    {
+        int start(info.mPasswordStart[i]);
+
+        std::fill(mDisplayData.begin() + start, mDisplayData.begin() + start + info.mWordLength, i + 1);
+        mEntities.addPassword(i + 1, start, start + info.mWordLength);
+    }
 
-    std::random_shuffle(list.begin(), list.end());
+    mPasswordIndex = info.mAnswer;
+    mEntities.setAnswer(mPasswordIndex + 1);
+}
 
-    size_t maxwords(9);
+template<class GEOMETRY>
+BoardScore BasicGameBoard<GEOMETRY>::getScore() const
+{
+    return BoardScorer::score(mPasswords.data(), mPasswords.size(), int(mEntities.getDudCount()));
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::exportBoard(BoardRecordInfo &info, char *cells) const
+{
+    info = BoardRecordInfo();
+    std::copy(mDisplayField.begin(), mDisplayField.end(), cells);
+
+    for (size_t i = 0; i < mPasswords.size(); ++i)
+    {
+        info.mPasswordStart[i] = uint16_t(mEntities.find(int(i + 1))->mStart);
+    }
+    info.mPasswordCount = uint8_t(mPasswords.size());
+    info.mAnswer = uint8_t(std::max(mPasswordIndex, 0));
+    info.mWordLength = uint8_t(mPasswords.empty() ? 0 : mPasswords[0].size());
+    info.mDifficulty = uint8_t(mPlayDifficulty);
+    info.mDudCount = uint8_t(std::min<size_t>(mEntities.getDudCount(), 255));
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::selectPasswords()
+{
+    const WordBucket &wordset(mWords->selectWordSet(mPlayDifficulty, mRandom));
+    if (wordset.empty())
+        return;
+
+    // placePasswords() gives each word a span of its length plus a gap
+    // either side, small runtime geometries hold fewer than the maximum.
+    size_t fits(std::max<size_t>(1, mGeometry.getLength() / (wordset.getWordLength() + 2)));
+    size_t wordcount(std::min({ wordset.size(), sMaxPasswords, fits }));
+
+    // Floyd's algorithm picks wordcount distinct words without copying
+    // the bucket, the shuffle then randomizes their placement.
+    std::array<size_t, sMaxPasswords> picks;
+    for (size_t j = wordset.size() - wordcount, count = 0; j < wordset.size(); ++j, ++count)
+    {
+        size_t pick(mRandom() % (j + 1));
+        if (std::find(picks.begin(), picks.begin() + count, pick) != picks.begin() + count)
+            pick = j;
+        picks[count] = pick;
+    }
+    std::shuffle(picks.begin(), picks.begin() + wordcount, mRandom);
+
+    for (size_t i = 0; i < wordcount; ++i)
+    {
+        mPasswords.push_back(wordset[picks[i]]);
+    }
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::placePasswords()
+{
+    if (mPasswords.empty())
+    {
+        mPasswordIndex = -1;
+        return;
+    }
+
+    int total_length(mGeometry.getLength());
+    size_t wordlength(mPasswords[0].size());
+
+    size_t span(total_length / mPasswords.size());
+    size_t padding(std::max<int>(1, (int(span) - 2 - int(wordlength)) / 2));
 
-    size_t wordcount(std::min(list.size(), maxwords));
-    size_t span(total_length / wordcount);
-    size_t padding(((span - 2) - wordlength) / 2);
-  
     size_t count(0);
-    for (const std::string &word : list)
+    for (std::string_view word : mPasswords)
     {
-        if (count >= wordcount)
+        size_t start((mRandom() % padding) + (count * span));
+        if (start + wordlength > size_t(total_length))
             break;
-        size_t start((std::rand() % padding) + (count * span));
-        mPasswords.push_back(word);
-        std::string::iterator it_start(mDisplayField.begin() + start);
-        std::vector<int>::iterator it_markers(mDisplayData.begin() + start);
+        auto it_start(mDisplayField.begin() + start);
+        auto it_markers(mDisplayData.begin() + start);
 
         std::copy(word.begin(), word.end(), it_start);
         std::fill(it_markers, it_markers + wordlength, int(count + 1));
+        mEntities.addPassword(int(count + 1), int(start), int(start + wordlength));
         ++count;
     }
+    mPasswords.resize(count);
 
-    mPasswordIndex = std::rand() % mPasswords.size();
+    mPasswordIndex = mRandom() % mPasswords.size();
+    mEntities.setAnswer(mPasswordIndex + 1);
 }
 
-void GameBoard::initializeDuds()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::initializeDuds()
 {
     int    dud_count(0);
     size_t end_pos(mDisplayField.size());
@@ -201,27 +422,29 @@ void GameBoard::initializeDuds()
 
     while(true)
     {
-        end_pos = mDisplayField.find_last_of(CLOSING_CHARS, end_pos);
+        end_pos = find_last_of(mDisplayField, CLOSING_CHARS, end_pos);
         if (end_pos == std::string::npos)
             break;
 
-        char opening_brace = MATCHING_BRACE[ mDisplayField[end_pos] ];
-        start_pos = mDisplayField.find_last_of(opening_brace, end_pos);
+        char opening_brace = MATCHING_BRACE.at(mDisplayField[end_pos]);
+        start_pos = find_last_of(mDisplayField, std::string_view(&opening_brace, 1), end_pos);
 
         if (start_pos != std::string::npos)
         {   // found the matching open brace
-            std::string dud_span(mDisplayField.substr(start_pos, (end_pos - start_pos)+1));
+            auto dud_start(mDisplayField.begin() + start_pos);
+            auto dud_end(mDisplayField.begin() + end_pos + 1);
 
-            if (dud_span.size() < sFieldWidth)
+            if ((end_pos - start_pos + 1) < size_t(mGeometry.getWidth()))
             {
-                if (std::find_if(dud_span.begin(), dud_span.end(),
-                        [](const char &c) { return std::isalpha(c); }) == dud_span.end())
+                if (std::find_if(dud_start, dud_end,
+                        [](const char &c) { return std::isalpha(c); }) == dud_end)
                 {   // no aplhabetic chars in the span
                     dud_count++;
                     for (size_t i = start_pos; i <= end_pos; ++i)
                     {
                         mDisplayData[i] = -dud_count;
                     }
+                    mEntities.addDud(-dud_count, int(start_pos), int(end_pos + 1));
                     end_pos = start_pos;
                     continue;
                 }
@@ -235,61 +458,366 @@ void GameBoard::initializeDuds()
     }
 }
 
-bool GameBoard::play()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::playSession()
 {
-    while (!mExit)
+    KeyChannel keys;
+    SessionTask session(runSession(keys));
+
+    while (!session.done())
     {
-        int key(getch());
+        int key(mInput->readKey());
+        if (key != ERR)
+            TRACE_INSTANT("key");
+        keys.push(key);
+    }
 
-        if (key == ERR)
-            continue;
+    return session.result();
+}
 
-        switch (key)
+template<class GEOMETRY>
+SessionTask BasicGameBoard<GEOMETRY>::runSession(KeyChannel &keys)
+{
+    bool win(false);
+
+    if (mStats)
+        mStats->addSession();
+
+    bool resumed(mCheckpoint && resumeCheckpoint());
+    while(true)
+    {
+        if (!resumed)
         {
-        case KEY_ESC:
-            mExit = true;
-            break;
+            initialize();
+            if (mCheckpoint)
+                saveCheckpoint();
+        }
+        resumed = false;
 
-        case KEY_UP:
-        case KEY_DOWN:
-        case KEY_LEFT:
-        case KEY_RIGHT:
-            if (moveCursor(key))
-                displayField();
-            else
-                beep();
-            break;
+        bool ended(false);
+        while (!mExit)
+        {
+            int key(co_await keys.next());
+
+            if (key == ERR)
+                continue;
+            if (key == InputSource::sEndOfInput)
+            {
+                ended = true;
+                break;
+            }
 
-        case KEY_RETURN:
-        case KEY_ENTER:
-            handleEnter();
+            handleKey(key);
+            mRenderer->flush();
+            if (mCheckpoint)
+                saveCheckpoint();
+        }
+        win = mWin;
+        recordEvent(GameEvent::BOARD_END, win, mTurnsRemaining);
+
+        if (ended || mOpts->mSinglePlay || (win && mOpts->mPlayUntilWin))
             break;
 
-        default:
-            beep();
+        writeStatus("\nPLAY AGAIN? [Y/N]");
+        mRenderer->flush();
+        int ch;
+        while(true)
+        {
+            ch = co_await keys.next();
+            if ((ch == 'Y') || (ch == 'y') || (ch == 'N') || (ch == 'n'))
+                break;
+            if (ch == InputSource::sEndOfInput)
+                break;
+            if ((ch == KEY_PPAGE) || (ch == KEY_NPAGE))
+            {
+                scrollStatus(ch);
+                mRenderer->flush();
+            }
+            else if (ch != ERR)
+            {
+                mRenderer->beep();
+                mRenderer->flush();
+            }
+        }
+
+        if ((ch != 'Y') && (ch != 'y'))
             break;
+    }
+
+    co_return win;
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::handleKey(int key)
+{
+    TRACE_SPAN("handleKey");
+    recordEvent(GameEvent::KEY, key);
+
+    // Any other key returns the status panel to the live view first.
+    if (mStatusHistory.isScrolled() && (key != KEY_PPAGE) && (key != KEY_NPAGE))
+    {
+        mStatusHistory.resetScroll();
+        mStatusHistory.render(*mPanelStatus);
+    }
+
+    switch (key)
+    {
+    case KEY_ESC:
+        mExit = true;
+        break;
+
+    case KEY_UP:
+    case KEY_DOWN:
+    case KEY_LEFT:
+    case KEY_RIGHT:
+        if (moveCursor(key))
+            displayCursor();
+        else
+            mRenderer->beep();
+        break;
+
+    case KEY_RETURN:
+    case KEY_ENTER:
+        handleEnter();
+        break;
+
+    case KEY_PPAGE:
+    case KEY_NPAGE:
+        scrollStatus(key);
+        break;
+
+    default:
+        mRenderer->beep();
+        break;
+    }
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::saveCheckpoint()
+{
+    // A finished board, or one too odd to store, leaves nothing to resume.
+    size_t wordlength(mPasswords.empty() ? 0 : mPasswords[0].size());
+    if (mExit || !wordlength || (mPasswordIndex < 0) ||
+        (mPasswords.size() * wordlength > mDisplayField.size()) ||
+        (mCheckpoint->getLength() != int(mDisplayField.size())))
+    {
+        mCheckpoint->clear();
+        return;
+    }
+
+    SessionCheckpoint::Slot slot(mCheckpoint->prepare(mBoardVersion));
+    CheckpointInfo &info(*slot.mInfo);
+
+    info = CheckpointInfo();
+    info.mActive = 1;
+    info.mPasswordCount = uint8_t(mPasswords.size());
+    info.mWordLength = uint8_t(wordlength);
+    info.mPasswordIndex = int8_t(mPasswordIndex);
+    for (size_t i = 0; i < mPasswords.size(); ++i)
+    {
+        info.mPasswordStart[i] = uint16_t(mEntities.find(int(i + 1))->mStart);
+        if (mEntities.isLive(int(i + 1)))
+            info.mPasswordLive |= uint16_t(1 << i);
+    }
+    info.mTurnsRemaining = mTurnsRemaining;
+    info.mPlayDifficulty = mPlayDifficulty;
+    info.mCursor = mCursor.getPosition();
+    info.mDudCount = int32_t(mEntities.getDudCount());
+
+    // Moving the cursor leaves the board as the slot already has it.
+    if (!slot.mBoardCurrent)
+    {
+        for (size_t i = 0; i < mPasswords.size(); ++i)
+        {
+            std::copy(mPasswords[i].begin(), mPasswords[i].end(), slot.mWords + (i * wordlength));
         }
+        std::copy(mDisplayField.begin(), mDisplayField.end(), slot.mCells);
+        std::copy(mDisplayData.begin(), mDisplayData.end(), slot.mData);
+    }
+
+    mCheckpoint->commit(slot);
+}
+
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::resumeCheckpoint()
+{
+    SessionCheckpoint::Slot slot;
+    if ((mCheckpoint->getLength() != mGeometry.getLength()) || !mCheckpoint->load(slot))
+        return false;
+
+    const CheckpointInfo &info(*slot.mInfo);
+    int length(mGeometry.getLength());
+    // The checksum only catches torn writes, every field that sizes or
+    // bounds something is checked before it is trusted.
+    if (!info.mPasswordCount || (info.mPasswordCount > sMaxPasswords) || !info.mWordLength ||
+        (info.mPasswordIndex < 0) || (info.mPasswordIndex >= info.mPasswordCount) ||
+        (info.mCursor < 0) || (info.mCursor >= length) ||
+        (info.mTurnsRemaining < 1) || (info.mTurnsRemaining > sMaxTurns) ||
+        (info.mPlayDifficulty < 1) || (info.mPlayDifficulty > 3) ||
+        (info.mDudCount < 0) || (info.mDudCount > (length / 2)))
+        return false;
+    for (int i = 0; i < info.mPasswordCount; ++i)
+    {
+        if (info.mPasswordStart[i] + info.mWordLength > length)
+            return false;
+    }
+
+    // The cell data names entities directly.  Every value has to be a
+    // known dud or password, and a password's cells have to be exactly
+    // its span while it stands and nowhere once it has been removed.
+    for (int cell = 0; cell < length; ++cell)
+    {
+        int value(slot.mData[cell]);
+        if ((value < -info.mDudCount) || (value > info.mPasswordCount))
+            return false;
+        if (value > 0)
+        {
+            int start(info.mPasswordStart[value - 1]);
+            if (!(info.mPasswordLive & (1 << (value - 1))) || (cell < start) || (cell >= start + info.mWordLength))
+                return false;
+        }
+    }
+    for (int i = 0; i < info.mPasswordCount; ++i)
+    {
+        if (!(info.mPasswordLive & (1 << i)))
+            continue;
+        for (int cell = info.mPasswordStart[i]; cell < info.mPasswordStart[i] + info.mWordLength; ++cell)
+        {
+            if (slot.mData[cell] != i + 1)
+                return false;
+        }
+    }
+
+    mTurnsRemaining = info.mTurnsRemaining;
+    mPlayDifficulty = info.mPlayDifficulty;
+    mWin = false;
+    mExit = false;
+
+    mPanelHeader->clear();
+    for (const RenderPanel::ptr_t &filler : mPanelFiller)
+    {
+        filler->clear();
+    }
+    for (const RenderPanel::ptr_t &field : mPanelField)
+    {
+        field->clear();
+    }
+    mStatusHistory.startPage();
+
+    mWords = mLibrary->snapshot();
+    mGeometry.allocate(mDisplayField);
+    mGeometry.allocate(mDisplayData);
+    std::copy(slot.mCells, slot.mCells + length, mDisplayField.begin());
+    std::copy(slot.mData, slot.mData + length, mDisplayData.begin());
+    ++mBoardVersion;
+
+    // The passwords may not be in the dictionary any more, they live in
+    // the arena for as long as the board.
+    mPasswords = password_vec_t(&mArena);
+    mArena.release();
+    mPasswords.reserve(sMaxPasswords);
+
+    size_t text_length(size_t(info.mPasswordCount) * info.mWordLength);
+    char *text(static_cast<char *>(mArena.allocate(text_length, 1)));
+    std::copy(slot.mWords, slot.mWords + text_length, text);
+
+    mEntities.clear();
+    for (int i = 0; i < info.mPasswordCount; ++i)
+    {
+        int start(info.mPasswordStart[i]);
+
+        mPasswords.emplace_back(text + (i * info.mWordLength), info.mWordLength);
+        mEntities.addPassword(i + 1, start, start + info.mWordLength);
+        if (!(info.mPasswordLive & (1 << i)))
+            mEntities.remove(i + 1);
+    }
+
+    // Duds still standing are runs of their id in the cell data, the
+    // rest were removed.
+    for (int id = 1; id <= info.mDudCount; ++id)
+    {
+        mEntities.addDud(-id, 0, 0);
+        mEntities.remove(-id);
     }
+    for (int start = 0; start < length; )
+    {
+        int value(mDisplayData[start]);
+        int end(start + 1);
+        while ((end < length) && (mDisplayData[end] == value))
+            ++end;
+
+        if ((value < 0) && (-value <= info.mDudCount))
+            mEntities.addDud(value, start, end);
+        start = end;
+    }
+
+    mPasswordIndex = info.mPasswordIndex;
+    mEntities.setAnswer(mPasswordIndex + 1);
+    mCursor.setPosition(info.mCursor);
+    recordEvent(GameEvent::BOARD_START, mPlayDifficulty, int32_t(mPasswords.size()));
 
-    return mWin;
+    displayHeader();
+    displayFiller();
+    displayField();
+    writeStatus("SESSION RESUMED\n");
+    displayStatus();
+
+    mRenderer->flush();
+    return true;
 }
 
-bool GameBoard::moveCursor(int key)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::recordEvent(GameEvent::Type type, int32_t arg1, int32_t arg2)
 {
+    if (mEvents)
+        mEvents->push(type, arg1, arg2);
+
+    if (!mStats)
+        return;
+
+    switch (type)
+    {
+    case GameEvent::BOARD_START:
+        mBoardStart = std::chrono::steady_clock::now();
+        break;
+    case GameEvent::BOARD_END:
+        mStats->addGame(mPlayDifficulty, arg1 != 0, std::chrono::steady_clock::now() - mBoardStart);
+        break;
+    case GameEvent::GUESS:
+        mStats->addGuess();
+        break;
+    case GameEvent::DUD_REMOVED:
+        mStats->addDudRemoved();
+        break;
+    case GameEvent::DECOY_REMOVED:
+        mStats->addDecoyRemoved();
+        break;
+    case GameEvent::TURNS_RESET:
+        mStats->addTurnReset();
+        break;
+    default:
+        break;
+    }
+}
+
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::moveCursor(int key)
+{
+    TRACE_SPAN("moveCursor");
     bool success(false);
     switch (key)
     {
     case KEY_UP:
-        success = mCursor->advanceUp();
+        success = mCursor.advanceUp();
         break;
     case KEY_DOWN:
-        success = mCursor->advanceDown();
+        success = mCursor.advanceDown();
         break;
     case KEY_LEFT:
-        success = mCursor->advanceLeft();
+        success = mCursor.advanceLeft();
         break;
     case KEY_RIGHT:
-        success = mCursor->advanceRight();
+        success = mCursor.advanceRight();
         break;
     default:
         break;
@@ -298,12 +826,14 @@ bool GameBoard::moveCursor(int key)
     return success;
 }
 
-bool GameBoard::handleEnter()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::handleEnter()
 {
-    if (!mCursor->isOnRange())
+    TRACE_SPAN("handleEnter");
+    if (!mCursor.isOnRange())
         return false;
 
-    int selected(mCursor->getRangeValue());
+    int selected(mCursor.getRangeValue());
     if (selected > 0)
     {
         handlePasswordGuess(selected);
@@ -318,232 +848,263 @@ bool GameBoard::handleEnter()
     return true;
 }
 
-void GameBoard::handlePasswordGuess(int selected)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::handlePasswordGuess(int selected)
 {
     writeStatus(mPasswords[selected - 1]);
     writeStatus("\n");        
     int likeness(calculateLikeness(mPasswords[selected - 1]));
-    std::stringstream result;
-    if (likeness < mPasswords[selected - 1].size())
+    recordEvent(GameEvent::GUESS, selected, likeness);
+    if (likeness < int(mPasswords[selected - 1].size()))
     {
+        char result[64];
+        int length(std::snprintf(result, sizeof(result), "LIKENESS=%d\n\nENTRY DENIED!\n", likeness));
+
         failGuess(selected);
-        result << "LIKENESS=" << likeness << "\n\n";
-        result << "ENTRY DENIED!\n";
+        writeStatus(std::string_view(result, length));
     }
     else
     {
-        result << "ENTRY GRANTED!\n";
         mWin = true;
         mExit = true;
+        writeStatus("ENTRY GRANTED!\n");
     }
-    writeStatus(result.str());
 }
 
-void GameBoard::handleDudRemoval(int selected)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::handleDudRemoval(int selected)
 {
     clearSelection(selected);
     writeStatus("\n");
+    recordEvent(GameEvent::DUD_REMOVED, selected);
 
-    if ((std::rand() % 20) == 0)
+    if ((mRandom() % 20) == 0)
     {   // 5% chance to restore turns
         mTurnsRemaining = sMaxTurns;
+        recordEvent(GameEvent::TURNS_RESET, mTurnsRemaining);
         writeStatus("TURNS RESET\n");
-        displayHeader();
+        displayAttempts();
     }
     else
     {
-        std::set<int>   outstanding;
-        for (const int &value : mDisplayData)
-        {   // collect unselected duds
-            if ((value > 0) && ((value - 1) != mPasswordIndex))
-                outstanding.insert(value);
-        }
-        if (!outstanding.empty())
+        size_t duds(mEntities.getDecoyCount());
+        if (duds)
         {
-            size_t duds(outstanding.size());
-            size_t dud_remove(std::rand() % duds);
-
-            auto it_remove = outstanding.begin();
-            while (dud_remove--)
-                ++it_remove;
-
-            int dud_index = (*it_remove);
+            int dud_index(mEntities.getDecoy(mRandom() % duds));
 
             clearSelection(dud_index, true);
+            recordEvent(GameEvent::DECOY_REMOVED, dud_index);
             writeStatus("DUD REMOVED\n");
         }
     }
 }
 
-void GameBoard::displayHeader()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayHeader()
 {
     if (mPanelHeader)
     {
-        mvwprintw(mPanelHeader, 0, 0, "%s TERMLINK PROTOCOL\nENTER PASSWORD NOW", mCompanyName.c_str());
+        mPanelHeader->move(0, 0);
+        mPanelHeader->write(mHeaderText);
+        displayAttempts();
+    }
+}
 
-        mvwprintw(mPanelHeader, 3, 0, "ATTEMPTS REMAINING: %d ", mTurnsRemaining);
-        for (int i = 0; i < mTurnsRemaining; ++i)
-        {
-            waddch(mPanelHeader, '\xDB');
-            waddch(mPanelHeader, ' ');
-        }
-        wclrtoeol(mPanelHeader);
-        wrefresh(mPanelHeader);
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayAttempts()
+{
+    if (mPanelHeader)
+    {
+        mPanelHeader->move(3, 0);
+        mPanelHeader->write(mAttemptText[std::min(std::max(mTurnsRemaining, 0), sMaxTurns)]);
+        mPanelHeader->clearToEol();
+        mPanelHeader->refresh();
     }
 }
 
-void GameBoard::displayFiller()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayFiller()
 {
-    if (mPanelFiller[0] && mPanelFiller[1])
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    if (!mPanelFiller.empty())
     {
-        int address(generate_random_addr());
-        int limit(getmaxy(mPanelFiller[0]));
-        int span(getmaxx(mPanelField[0]));
+        int address(generate_random_addr(mRandom));
+        int limit(mGeometry.getHeight());
+        int span(mGeometry.getWidth());
 
-        for (int i = 0; i < (limit * 2); ++i)
-        {
-            mvwprintw(mPanelFiller[i / limit], i % limit, 0,
-                "0X%04X", address);
-            address += span;
-        }
-        for (WINDOW *filler : mPanelFiller)
+        // A gutter is exactly one address wide, so each field's addresses
+        // go out as one write that wraps a row per address.
+        for (const RenderPanel::ptr_t &filler : mPanelFiller)
         {
-            wrefresh(filler);
+            char *out(&mGutterText[0]);
+            for (int row = 0; row < limit; ++row, address += span)
+            {
+                *out++ = '0';
+                *out++ = 'X';
+                for (int shift = 12; shift >= 0; shift -= 4)
+                {
+                    *out++ = HEX_DIGITS[(address >> shift) & 0xF];
+                }
+            }
+
+            filler->move(0, 0);
+            filler->write(mGutterText);
+            filler->refresh();
         }
     }
 }
 
-void GameBoard::displayField()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayField()
 {
-    if (mPanelField[0] && mPanelField[1])
+    TRACE_SPAN("displayField");
+    if (!mPanelField.empty())
     {
-        int span(getmaxx(mPanelField[0]));
-        int limit(getmaxy(mPanelField[0]));
-
-        int field_length(span * limit);
-        std::string::iterator itStart(mDisplayField.begin());
-        std::string sub1(itStart, itStart + field_length);
-        std::string sub2(itStart + field_length, mDisplayField.end());
-
-        mvwprintw(mPanelField[0], 0, 0, "%s", sub1.c_str());
-        mvwprintw(mPanelField[1], 0, 0, "%s", sub2.c_str());
+        int field_length(mGeometry.getFieldLength());
 
-#if 0
-        for (int i = 0; i < mDisplayData.size(); ++i)
+        for (int field = 0; field < mGeometry.getFields(); ++field)
         {
-            if (mDisplayData[i] != 0)
-                continue;
-            std::stringstream convert;
-            convert << mDisplayData[i];
-
-            WINDOW *field(mPanelField[mCursor->convertToField(i)]);
-
-            int posy(mCursor->convertToY(i));
-            int posx(mCursor->convertToX(i));
-
-            mvwaddch(field, posy, posx, convert.str()[0]);
+            mPanelField[field]->move(0, 0);
+            mPanelField[field]->write(mDisplayField.data() + (field * field_length), field_length);
+            mPanelField[field]->refresh();
         }
-#endif
 
-        if (mCursor)
-        { 
-            if (mCursor->isOnRange())
-            {
-                for (int i = mCursor->getRangeStart(); i < mCursor->getRangeEnd(); ++i)
-                {
-                    WINDOW *field(mPanelField[mCursor->convertToField(i)]);
+        // Nothing is highlighted after a full redraw.
+        mHighlightStart = 0;
+        mHighlightEnd = 0;
+        displayCursor();
+    }
+}
 
-                    int posy(mCursor->convertToY(i));
-                    int posx(mCursor->convertToX(i));
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayCursor()
+{
+    TRACE_SPAN("displayCursor");
+    if (!mPanelField.empty())
+    {
+        int start(mCursor.getRangeStart());
+        int end(mCursor.isOnRange() ? mCursor.getRangeEnd() : (start + 1));
 
-                    wattrset(field, A_REVERSE);
-                    mvwaddch(field, posy, posx, mDisplayField[i]);
-                    wattroff(field, A_REVERSE);
-               }
+        // Only the cells leaving and entering the highlight are drawn.
+        if ((start != mHighlightStart) || (end != mHighlightEnd))
+        {
+            writeCells(mHighlightStart, mHighlightEnd, RenderPanel::ATTR_NORMAL);
+            writeCells(start, end, RenderPanel::ATTR_REVERSE);
+            mHighlightStart = start;
+            mHighlightEnd = end;
+        }
 
-                previewUnderCursor();
-            }
-            else
-            {
-                WINDOW *field(mPanelField[mCursor->getField()]);
+        if (mCursor.isOnRange())
+            previewUnderCursor();
+        else
+            clearPreview();
+    }
+}
 
-                int posy(mCursor->getY());
-                int posx(mCursor->getX());
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::writeCells(int start, int end, int attr)
+{
+    int field_length(mGeometry.getFieldLength());
 
-                wattrset(field, A_REVERSE);
-                mvwaddch(field, posy, posx, mDisplayField[mCursor->getPosition()]);
-                wattroff(field, A_REVERSE);
-                clearPreview();
-            }
-        }
-        for (WINDOW *field : mPanelField)
-        {
-            wrefresh(field);
-        }
+    // A range that crosses a field boundary is one write per field.
+    while (start < end)
+    {
+        int field(mGeometry.convertToField(start));
+        int stop(std::min(end, (field + 1) * field_length));
+        const RenderPanel::ptr_t &panel(mPanelField[field]);
+
+        panel->move(mGeometry.convertToY(start), mGeometry.convertToX(start));
+        panel->write(&mDisplayField[start], stop - start, attr);
+        panel->refresh();
+        start = stop;
     }
 }
 
-void GameBoard::displayStatus()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::displayStatus()
 {
     writeStatus("ENTER PASSWORD NOW\n> ");
 }
 
-void GameBoard::writeStatus(const std::string &status)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::writeStatus(std::string_view status)
+{
+    mStatusHistory.resetScroll();
+    mStatusHistory.append(status);
+    mStatusHistory.render(*mPanelStatus);
+}
+
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::scrollStatus(int key)
 {
-    wprintw(mPanelStatus, status.c_str());
+    // A page keeps one line of the last for context.
+    int height(mPanelStatus->getHeight());
+    int page(std::max(height - 1, 1));
+
+    if (!mStatusHistory.scrollBack((key == KEY_PPAGE) ? page : -page, height))
+    {
+        mRenderer->beep();
+        return;
+    }
+
+    mStatusHistory.render(*mPanelStatus);
+    if (!mStatusHistory.isScrolled() && mCursor.isOnRange() && !mExit)
+        previewUnderCursor();
 }
 
-void GameBoard::writePreview(const std::string &preview, bool restore_cursor)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::writePreview(std::string_view preview, bool restore_cursor)
 {
     int posx;
     int posy;
 
-    getyx(mPanelStatus, posy, posx);
-    wprintw(mPanelStatus, preview.c_str());
+    mPanelStatus->getCursor(posy, posx);
+    mPanelStatus->write(preview);
     if (restore_cursor)
-        wmove(mPanelStatus, posy, posx);
+        mPanelStatus->move(posy, posx);
+    mPanelStatus->refresh();
 }
 
-void GameBoard::clearPreview()
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::clearPreview()
 {
-    wclrtoeol(mPanelStatus);
+    mPanelStatus->clearToEol();
+    mPanelStatus->refresh();
 }
 
-bool GameBoard::previewUnderCursor(bool restore_cursor)
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::previewUnderCursor(bool restore_cursor)
 {
-    int selected = mCursor->getRangeValue();
+    int selected = mCursor.getRangeValue();
     
     if (!selected)
     {
         clearPreview();
         return false;
     }
-    std::string preview;
+    std::string_view preview;
     if (selected > 0)
         preview = mPasswords[selected - 1];
     else
     {
-        auto it_start = std::find(mDisplayData.begin(), mDisplayData.end(), selected);
-        auto it_end = std::find_if_not(it_start, mDisplayData.end(), [selected](int test) { return test == selected; });
-
-        size_t pos_start = std::distance(mDisplayData.begin(), it_start);
-        size_t pos_end = std::distance(mDisplayData.begin(), it_end);
-
-        preview = mDisplayField.substr(pos_start, (pos_end - pos_start));
+        const EntityRegistry::Entity *dud(mEntities.find(selected));
+        preview = std::string_view(mDisplayField.data() + dud->mStart, dud->mEnd - dud->mStart);
     }
     writePreview(preview);
     return true;
 }
 
-int GameBoard::calculateLikeness(const std::string &test)
+template<class GEOMETRY>
+int BasicGameBoard<GEOMETRY>::calculateLikeness(std::string_view test)
 {
     if (mPasswordIndex < 0)
         return 0;
 
     int likeness(0);
-    std::string password(mPasswords[mPasswordIndex]);
+    std::string_view password(mPasswords[mPasswordIndex]);
 
-    for (int i = 0; i < password.size(); ++i)
+    for (size_t i = 0; i < password.size(); ++i)
     {
         if (password[i] == test[i])
             ++likeness;
@@ -552,43 +1113,58 @@ int GameBoard::calculateLikeness(const std::string &test)
     return likeness;
 }
 
-void GameBoard::failGuess(int selection)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::failGuess(int selection)
 {
     clearSelection(selection);
     
     --mTurnsRemaining;
-    displayHeader();
+    recordEvent(GameEvent::TURN_LOST, mTurnsRemaining);
+    displayAttempts();
     if (!mTurnsRemaining)
         mExit = true;
 }
 
-void GameBoard::clearSelection(int selection, bool clear_text )
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::clearSelection(int selection, bool clear_text )
 {
-    size_t index(0);
-    for (int &value : mDisplayData)
+    const EntityRegistry::Entity *entity(mEntities.find(selection));
+    if (!entity || !mEntities.remove(selection))
+        return;
+
+    std::fill(mDisplayData.begin() + entity->mStart, mDisplayData.begin() + entity->mEnd, 0);
+    ++mBoardVersion;
+    if (clear_text)
     {
-        if (value == selection)
+        std::fill(mDisplayField.begin() + entity->mStart, mDisplayField.begin() + entity->mEnd, '.');
+
+        // Patch the removed cells, the highlight on them goes with them.
+        if (!mPanelField.empty())
         {
-            value = 0;
-            if (clear_text)
-                mDisplayField[index] = '.';
+            writeCells(entity->mStart, entity->mEnd, RenderPanel::ATTR_NORMAL);
+            if ((mHighlightStart < entity->mEnd) && (entity->mStart < mHighlightEnd))
+            {
+                writeCells(mHighlightStart, mHighlightEnd, RenderPanel::ATTR_NORMAL);
+                mHighlightEnd = mHighlightStart;
+            }
+            displayCursor();
         }
-        ++index;
     }
-    if (clear_text)
-        displayField();
 }
 
 //========================================================================
-GameBoard::GameCursor::GameCursor(int span, int limit, bool wrap, std::vector<int> &data):
+template<class GEOMETRY>
+BasicGameBoard<GEOMETRY>::GameCursor::GameCursor(const GEOMETRY &geometry, bool wrap, data_t &data,
+        const EntityRegistry &entities):
+    mFieldData(data),
+    mEntities(entities),
     mPosition(0),
-    mSpan(span),
-    mLimit(limit),
-    mFieldData(data)
+    mGeometry(geometry)
 {
 }
 
-bool GameBoard::GameCursor::advanceLeft()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::GameCursor::advanceLeft()
 {
     int field(getField());
     int x(getX());
@@ -598,7 +1174,7 @@ bool GameBoard::GameCursor::advanceLeft()
     {
         if (field > 0)
         {
-            x = mSpan - 1;
+            x = mGeometry.getWidth() - 1;
             --field;
         }
         else
@@ -615,15 +1191,16 @@ bool GameBoard::GameCursor::advanceLeft()
     return true;
 }
 
-bool GameBoard::GameCursor::advanceRight()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::GameCursor::advanceRight()
 {
     int field(getField());
     int x(getX());
     int y(getY());
 
-    if (x >= (mSpan - 1))
+    if (x >= (mGeometry.getWidth() - 1))
     {
-        if (field == 0)
+        if (field < (mGeometry.getFields() - 1))
         {
             x = 0;
             ++field;
@@ -642,7 +1219,8 @@ bool GameBoard::GameCursor::advanceRight()
     return true;
 }
 
-bool GameBoard::GameCursor::advanceUp()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::GameCursor::advanceUp()
 {
     int field(getField());
     int x(getX());
@@ -656,13 +1234,14 @@ bool GameBoard::GameCursor::advanceUp()
     return true;
 }
 
-bool GameBoard::GameCursor::advanceDown()
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::GameCursor::advanceDown()
 {
     int field(getField());
     int x(getX());
     int y(getY());
 
-    if (y >= (mLimit - 1))
+    if (y >= (mGeometry.getHeight() - 1))
         return false;
 
     ++y;
@@ -670,66 +1249,45 @@ bool GameBoard::GameCursor::advanceDown()
     return true;
 }
 
-void GameBoard::GameCursor::setPosition(int field, int x, int y)
+template<class GEOMETRY>
+void BasicGameBoard<GEOMETRY>::GameCursor::setPosition(int field, int x, int y)
 {
-    mPosition = (field * (mSpan * mLimit)) + (y * mSpan) + x;
+    mPosition = mGeometry.convertToPosition(field, x, y);
 }
 
-int GameBoard::GameCursor::convertToField(int position) const
-{
-    return (position / (mSpan * mLimit));
-}
-
-int GameBoard::GameCursor::convertToX(int position) const
-{
-    int field_length(mSpan * mLimit);
-
-    int subrange(position % field_length);
-
-    return (subrange % mSpan);
-}
-
-int GameBoard::GameCursor::convertToY(int position) const
-{
-    int field_length(mSpan * mLimit);
-
-    int subrange(position % field_length);
-
-    return (subrange / mSpan);
-}
-
-bool GameBoard::GameCursor::isOnRange() const
+template<class GEOMETRY>
+bool BasicGameBoard<GEOMETRY>::GameCursor::isOnRange() const
 {
     return (mFieldData[mPosition] != 0);
 }
 
-int GameBoard::GameCursor::getRangeValue() const
+template<class GEOMETRY>
+int BasicGameBoard<GEOMETRY>::GameCursor::getRangeValue() const
 {
     return (mFieldData[mPosition]);
 }
 
-int GameBoard::GameCursor::getRangeStart() const
+template<class GEOMETRY>
+int BasicGameBoard<GEOMETRY>::GameCursor::getRangeStart() const
 {
     if (!isOnRange())
         return mPosition;
 
-    int key(mFieldData[mPosition]);
-    std::vector<int>::iterator it_cur(mFieldData.begin() + mPosition);
-
-    std::vector<int>::iterator start(std::find(mFieldData.begin(), it_cur + 1, key));
-    return int(std::distance(mFieldData.begin(), start));
+    // A cell whose entity is unknown is treated as a range of itself.
+    const EntityRegistry::Entity *entity(mEntities.find(getRangeValue()));
+    return entity ? entity->mStart : mPosition;
 }
 
-int GameBoard::GameCursor::getRangeEnd() const
+template<class GEOMETRY>
+int BasicGameBoard<GEOMETRY>::GameCursor::getRangeEnd() const
 {
     if (!isOnRange())
         return mPosition;
 
-    int key(mFieldData[mPosition]);
-    std::vector<int>::iterator it_cur(mFieldData.begin() + mPosition);
-
-    std::vector<int>::iterator end(std::find_if_not(it_cur, mFieldData.end(), 
-        [key](const int &test) { return test == key; }));
-
-    return mPosition + int(std::distance(it_cur, end));
+    const EntityRegistry::Entity *entity(mEntities.find(getRangeValue()));
+    return entity ? entity->mEnd : (mPosition + 1);
 }
+
+//========================================================================
+template class BasicGameBoard<StandardGeometry>;
+template class BasicGameBoard<RuntimeGeometry>;
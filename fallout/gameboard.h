@@ -5,24 +5,44 @@
 #define FALLOUT_GAMEBOARD_H
 
 #include <memory>
+#include <memory_resource>
 #include <array>
 #include <vector>
-#include <curses.h>
+#include <string_view>
+#include <chrono>
 
 #include "fallout.h"
 #include "gamedata.h"
-
-class GameBoard
+#include "wordlibrary.h"
+#include "renderer.h"
+#include "inputsource.h"
+#include "boardgeometry.h"
+#include "boardlibrary.h"
+#include "boardscorer.h"
+#include "checkpoint.h"
+#include "memoryaccount.h"
+#include "entityregistry.h"
+#include "eventlog.h"
+#include "fillergenerator.h"
+#include "sharedstats.h"
+#include "statushistory.h"
+#include "sessiontask.h"
+
+template<class GEOMETRY>
+class BasicGameBoard
 {
 public:
-    typedef std::shared_ptr<GameBoard> ptr_t;
+    typedef std::shared_ptr<BasicGameBoard> ptr_t;
+    typedef GEOMETRY                        geometry_t;
+    typedef typename GEOMETRY::template storage_t<char> field_t;
+    typedef typename GEOMETRY::template storage_t<int>  data_t;
 
     class GameCursor
     {
     public:
         typedef std::shared_ptr<GameCursor> ptr_t;
 
-        GameCursor(int span, int limit, bool wrap, std::vector<int> &data);
+        GameCursor(const GEOMETRY &geometry, bool wrap, data_t &data, const EntityRegistry &entities);
 
         bool        advanceLeft();
         bool        advanceRight();
@@ -42,78 +62,188 @@ public:
         int         getRangeStart() const;
         int         getRangeEnd() const;
 
-        int         convertToField(int position) const;
-        int         convertToX(int position) const;
-        int         convertToY(int position) const;
+        int         convertToField(int position) const  { return mGeometry.convertToField(position); }
+        int         convertToX(int position) const      { return mGeometry.convertToX(position); }
+        int         convertToY(int position) const      { return mGeometry.convertToY(position); }
 
     private:
-        std::vector<int> &  mFieldData;
+        data_t &            mFieldData;
+        const EntityRegistry &  mEntities;
         int                 mPosition;
 
-        int                 mSpan;
-        int                 mLimit;
+        GEOMETRY            mGeometry;
     };
 
-    GameBoard(WINDOW *mainwindow, const FalloutWords::ptr_t &words, const OptionsData::ptr_t &opts);
-    ~GameBoard();
+    BasicGameBoard(const Renderer::ptr_t &renderer, const InputSource::ptr_t &input,
+        const WordLibrary::ptr_t &library, const OptionsData::ptr_t &opts,
+        const GEOMETRY &geometry = GEOMETRY());
+    ~BasicGameBoard();
+
+    void                    seed(unsigned int value) { mRandom.seed(value); }
 
     void                    initialize();
-    bool                    play();
-    void                    writeStatus(const std::string &status);
+
+    /// Draw the terminal around an empty board while the dictionary is
+    /// still loading, then update the word count as it goes.  Uses the
+    /// random generator, seed() the board again afterwards.
+    void                    beginLoading();
+    void                    showLoading(size_t words);
+
+    /// Play boards until the player quits, reading keys from the input
+    /// source.  Returns whether the last board was won.
+    bool                    playSession();
+
+    /// The same session as a coroutine that waits on keys instead of
+    /// reading them, for driving many boards from one SessionLoop.  The
+    /// board must outlive the task.
+    SessionTask             runSession(KeyChannel &keys);
+    void                    writeStatus(std::string_view status);
 
     void                    setPlayDifficulty(int difficulty);
     int                     getPlayDifficulty() const { return mPlayDifficulty; }
 
-    static const int        sFieldWidth;
-    static const int        sFieldHeight;
+    const GEOMETRY &        getGeometry() const { return mGeometry; }
+
+    /// Draw boards from a pre-generated library when it has one of the
+    /// right size and difficulty, instead of generating them.
+    void                    setBoardLibrary(const BoardLibrary::ptr_t &library) { mBoardLibrary = library; }
+
+    /// Record what the player does to an event log, each board gets its
+    /// own ring in it.
+    void                    setEventLog(const EventLog::ptr_t &log) { mEvents = log ? log->createRing() : EventRing::ptr_t(); }
+
+    /// Save the board after every key, and pick up a board left in
+    /// progress there when the session starts.
+    void                    setCheckpoint(const SessionCheckpoint::ptr_t &checkpoint) { mCheckpoint = checkpoint; }
+
+    /// Add this board's games to host wide counters.
+    void                    setStats(const SharedStats::ptr_t &stats)   { mStats = stats; }
+
+    /// Difficulty of the current board.
+    BoardScore              getScore() const;
+
+    /// Save the current board as a library record, cells must have room
+    /// for the whole geometry.
+    void                    exportBoard(BoardRecordInfo &info, char *cells) const;
+
     static const int        sMaxTurns;
 
 private:
+    void                    handleKey(int key);
     bool                    moveCursor(int key);
     bool                    handleEnter();
     void                    handlePasswordGuess(int selected);
     void                    handleDudRemoval(int selected);
 
     void                    displayHeader();
+    void                    displayAttempts();
     void                    displayFiller();
     void                    displayField();
+    void                    displayCursor();
+    void                    writeCells(int start, int end, int attr);
     void                    displayStatus();
 
-    void                    writePreview(const std::string &status, bool restore_cursor = true);
+    void                    scrollStatus(int key);
+    void                    writePreview(std::string_view status, bool restore_cursor = true);
     void                    clearPreview();
     bool                    previewUnderCursor(bool restore_cursor = true);
 
     void                    initializeGameData();
-    void                    initializeWords();
+    bool                    drawLibraryBoard(BoardLibrary::Board &board);
+    void                    loadLibraryBoard(const BoardLibrary::Board &board);
+    void                    selectPasswords();
+    void                    placePasswords();
     void                    initializeDuds();
 
-    int                     calculateLikeness(const std::string &test);
+    int                     calculateLikeness(std::string_view test);
     void                    failGuess(int selection);
     void                    clearSelection(int selection, bool clear_text = false);
 
-    WINDOW *                mGameWindow;
-    
-    WINDOW *                mPanelHeader;
-    WINDOW *                mPanelStatus;
-    std::array<WINDOW *, 2> mPanelFiller;
-    std::array<WINDOW *, 2> mPanelField;
-
-    std::string             mCompanyName;
+    void                    saveCheckpoint();
+    bool                    resumeCheckpoint();
+
+    void                    recordEvent(GameEvent::Type type, int32_t arg1 = 0, int32_t arg2 = 0);
+
+    typedef std::vector<RenderPanel::ptr_t> panel_vec_t;
+    typedef std::pmr::vector<std::string_view> password_vec_t;
+
+    static constexpr size_t sMaxPasswords = 9;
+    static constexpr size_t sArenaSize = 4096;
+    static const int        sMaxScoreAttempts = 256;
+
+    // Charged with the board itself, its per-cell storage when that is
+    // not fixed, the text it caches, the status history, the entity
+    // registry and anything the arena takes beyond its buffer.  The
+    // panels belong to the renderer and are not counted.
+    MemoryAccount           mMemory;
+
+    GEOMETRY                mGeometry;
+    Renderer::ptr_t         mRenderer;
+    InputSource::ptr_t      mInput;
+    FalloutWords::random_t  mRandom;
+    FillerGenerator         mFiller;
+
+    RenderPanel::ptr_t      mPanelHeader;
+    RenderPanel::ptr_t      mPanelStatus;
+    panel_vec_t             mPanelFiller;
+    panel_vec_t             mPanelField;
+    StatusHistory           mStatusHistory;
+
+    std::pmr::string        mCompanyName;
+    std::pmr::string        mHeaderText;
+    std::pmr::vector<std::pmr::string> mAttemptText;    // by turns remaining
+    std::pmr::string        mGutterText;        // one field's addresses
+    int                     mHighlightStart;    // cells drawn reversed
+    int                     mHighlightEnd;
     int                     mTurnsRemaining;
     int                     mPasswordIndex;
+    uint64_t                mBoardVersion;      // bumped whenever the cells change
 
-    std::string             mDisplayField;
-    std::vector<int>        mDisplayData;
+    field_t                 mDisplayField;
+    data_t                  mDisplayData;
 
-    GameCursor::ptr_t       mCursor;
+    EntityRegistry          mEntities;
+    GameCursor              mCursor;
     int                     mPlayDifficulty;
     bool                    mExit;
     bool                    mWin;
 
-    FalloutWords::string_vec_t  mPasswords;
-
-    FalloutWords::ptr_t     mWords; 
+    // Scratch memory for one board, released by initialize().  Words
+    // are views into the mWords snapshot, which outlives the board.
+    std::array<std::byte, sArenaSize>   mArenaBuffer;
+    std::pmr::monotonic_buffer_resource mArena;
+    password_vec_t          mPasswords;
+
+    WordLibrary::ptr_t      mLibrary;
+    FalloutWords::ptr_t     mWords;         // snapshot for the current board
+    BoardLibrary::ptr_t     mBoardLibrary;
+    EventRing::ptr_t        mEvents;
+    SharedStats::ptr_t      mStats;
+    SessionCheckpoint::ptr_t    mCheckpoint;
+    std::chrono::steady_clock::time_point   mBoardStart;
     OptionsData::ptr_t      mOpts;
 };
 
+typedef BasicGameBoard<StandardGeometry>    GameBoard;
+typedef BasicGameBoard<RuntimeGeometry>     RuntimeGameBoard;
+
+/// Boards of the standard size use the compile time layout, anything
+/// else has to go through RuntimeGameBoard.
+inline bool is_standard_geometry(const OptionsData &opts)
+{
+    StandardGeometry standard;
+
+    return (opts.mFields == standard.getFields()) &&
+        (opts.mFieldWidth == standard.getWidth()) &&
+        (opts.mFieldHeight == standard.getHeight());
+}
+
+inline RuntimeGeometry runtime_geometry(const OptionsData &opts)
+{
+    return RuntimeGeometry(opts.mFields, opts.mFieldWidth, opts.mFieldHeight);
+}
+
+extern template class BasicGameBoard<StandardGeometry>;
+extern template class BasicGameBoard<RuntimeGeometry>;
+
 #endif // !FALLOUT_GAMEBOARD_H
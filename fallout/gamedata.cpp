@@ -3,81 +3,232 @@
 
 #include "fallout.h"
 #include "gamedata.h"
+#include "wordreader.h"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <fstream>
+#include <new>
 #include <boost/algorithm/string.hpp>
 
 //========================================================================
-bool FalloutWords::loadWordList(const std::string &filename)
+namespace
 {
-    std::ifstream wordlist(filename);
+    // Lengths with fewer words than this are dropped, they would make
+    // boards too easy to guess.
+    const size_t MIN_BUCKET_WORDS(10);
 
-    if (wordlist.fail())
+    // Words between progress callbacks.
+    const size_t PROGRESS_INTERVAL(1024);
+
+    // Flat open addressing set over the words already appended to one
+    // bucket.  Slots hold the full hash and the word index, so probing
+    // only touches the strings on a hash match.
+    class WordDedupe
+    {
+    public:
+        WordDedupe():
+            mSlots(sInitialSlots, &FalloutWords::getMemory()),
+            mCount(0)
+        {}
+
+        /// Append word to bucket unless it is already there.
+        bool insert(const std::string &word, WordBucket &bucket)
+        {
+            if ((mCount + 1) * 2 > mSlots.size())
+                grow();
+
+            uint32_t hash(hashWord(word));
+            size_t mask(mSlots.size() - 1);
+            for (size_t i = hash & mask; ; i = (i + 1) & mask)
+            {
+                Slot &slot(mSlots[i]);
+                if (!slot.mIndex)
+                {
+                    bucket.push_back(word);
+                    slot.mHash = hash;
+                    slot.mIndex = static_cast<uint32_t>(bucket.size());
+                    ++mCount;
+                    return true;
+                }
+                if ((slot.mHash == hash) && (bucket[slot.mIndex - 1] == word))
+                    return false;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t    mHash   = 0;
+            uint32_t    mIndex  = 0;    // 1 based, 0 is empty
+        };
+
+        static const size_t sInitialSlots = 64;
+
+        static uint32_t hashWord(const std::string &word)
+        {   // FNV-1a
+            uint32_t hash(2166136261u);
+            for (unsigned char c : word)
+            {
+                hash = (hash ^ c) * 16777619u;
+            }
+            return hash;
+        }
+
+        void grow()
+        {
+            std::pmr::vector<Slot> slots(mSlots.size() * 2, mSlots.get_allocator());
+            size_t mask(slots.size() - 1);
+
+            for (const Slot &slot : mSlots)
+            {
+                if (!slot.mIndex)
+                    continue;
+                size_t i(slot.mHash & mask);
+                while (slots[i].mIndex)
+                    i = (i + 1) & mask;
+                slots[i] = slot;
+            }
+            mSlots.swap(slots);
+        }
+
+        std::pmr::vector<Slot>  mSlots;
+        size_t              mCount;
+    };
+}
+
+//========================================================================
+MemoryAccount &FalloutWords::getMemory()
+{
+    static MemoryAccount memory("dictionary");
+    return memory;
+}
+
+bool FalloutWords::loadWordList(const std::string &filename, bool verbose, const progress_t &progress)
+{
+    // Going over the budget throws from wherever the words are stored,
+    // the half built dictionary is then discarded by the caller.
+    try
     {
-        std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+        return readWordList(filename, verbose, progress);
+    }
+    catch (const std::bad_alloc &)
+    {
+        if (verbose)
+        {
+            std::cerr << std::endl << "Out of memory loading \"" << filename << "\"";
+            if (getMemory().getBudget())
+                std::cerr << ", the dictionary budget is " << (getMemory().getBudget() >> 20) << " MB";
+            std::cerr << std::endl;
+        }
         return false;
     }
+}
+
+bool FalloutWords::readWordList(const std::string &filename, bool verbose, const progress_t &progress)
+{
+    WordReader wordlist;
+
+    if (!wordlist.open(filename, verbose))
+        return false;
     
+    std::map<size_t, WordDedupe> dedupe;
+
     size_t count(0);
     std::string word;
-    while (wordlist >> word)
+    while (wordlist.next(word))
     {
         size_t length(word.size());
         if (length > 3)
         {
             ++count;
             boost::to_upper(word);
-            mMasterLists[length].insert(word);
-            std::cout << ".";
+            dedupe[length].insert(word, mMasterLists.try_emplace(length, length, &getMemory()).first->second);
+            if (verbose)
+                std::cout << ".";
+            if (progress && !(count % PROGRESS_INTERVAL) && !progress(count))
+                return false;
         }
-        else
+        else if (verbose)
         {
             std::cout << "X";
         }
     }
 
-    std::cerr << std::endl << "Loaded " << count << " words." << std::endl;
+    if (wordlist.failed())
+    {
+        if (verbose)
+            std::cerr << std::endl << "Error reading \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    if (verbose)
+        std::cerr << std::endl << "Loaded " << count << " words." << std::endl;
+
+    dedupe.clear();
+    for (auto &it : mMasterLists)
+    {
+        it.second.sort();
+    }
 
     size_t total(0);
     for (auto it = mMasterLists.begin(); it != mMasterLists.end(); )
     {
-        if ((*it).second.size() < 10)
+        if ((*it).second.size() < MIN_BUCKET_WORDS)
         {
-            std::cerr << "Discarding " << (*it).second.size() <<
-                " words of length " << (*it).first << std::endl;
+            if (verbose)
+                std::cerr << "Discarding " << (*it).second.size() <<
+                    " words of length " << (*it).first << std::endl;
             mMasterLists.erase(it++);
         }
         else
         {
             total += ((*it).second.size());
-            std::cerr << (*it).second.size() << " words of length " << (*it).first << std::endl;
+            if (verbose)
+                std::cerr << (*it).second.size() << " words of length " << (*it).first << std::endl;
             ++it;
         }
     }
 
-    std::cerr << "Dictionary contains " << total << " words." << std::endl;
+    if (verbose)
+        std::cerr << "Dictionary contains " << total << " words." << std::endl;
 
+    buildTiers(mMasterLists);
+    if (progress)
+        progress(count);
     return true;
 }
 
-void FalloutWords::dump()
+FalloutWords::ptr_t FalloutWords::copyPlayable(int difficulty) const
 {
+    ptr_t words(std::make_shared<FalloutWords>(mWeighting));
+
     for (const auto &it : mMasterLists)
     {
-        std::cerr << "Size: " << it.first << " count: " << it.second.size() << std::endl <<
-            "===================================" << std::endl;
+        if (it.second.size() < MIN_BUCKET_WORDS)
+            continue;
 
-        for (const std::string &word : it.second)
-        {
-            std::cerr << word << " ";
-        }
-        std::cerr << std::endl << "===================================" << std::endl << std::endl;
+        WordBucket &bucket(words->mMasterLists.try_emplace(it.first, it.second, &getMemory()).first->second);
+        bucket.sort();
     }
+
+    if (!words->isPlayable())
+        return ptr_t();
+
+    // The tiers are split over every length read so far, full or not, so
+    // the first lengths to fill don't stand in for the hard tier.  Until
+    // the wanted tier has words the copy would only borrow another's.
+    words->buildTiers(mMasterLists);
+    if (difficulty && words->mTiers[difficulty - 1].mBuckets.empty())
+        return ptr_t();
+    return words;
 }
-//------------------------------------------------------------------------
-const  FalloutWords::string_set_t & FalloutWords::selectWordSet(int difficulty) const
+
+void FalloutWords::buildTiers(const string_length_map_t &layout)
 {
-    size_t bucket_count(mMasterLists.size());
+    // Split the layout's lengths into thirds, shortest words are
+    // easiest.  Any slop goes to the middle tier first, then the easy
+    // one.  Lengths this dictionary has no bucket for are left out.
+    size_t bucket_count(layout.size());
     std::array<size_t, 3>   ranges;
 
     size_t bucket_size(bucket_count / 3);
@@ -95,24 +246,106 @@ const  FalloutWords::string_set_t & FalloutWords::selectWordSet(int difficulty)
         ranges[1] += 1;
     }
 
-    if (!difficulty)
-        difficulty = std::rand() % 3;
-    else 
-        difficulty -= 1;
+    string_length_map_t::const_iterator itset(layout.begin());
+    for (size_t tier = 0; tier < mTiers.size(); ++tier)
+    {
+        Tier &current(mTiers[tier]);
+        current = Tier();
 
-    string_length_map_t::const_iterator itset(mMasterLists.begin());
+        std::vector<double> weights;
+        for (size_t i = 0; i < ranges[tier]; ++i, ++itset)
+        {
+            string_length_map_t::const_iterator found(mMasterLists.find((*itset).first));
+            if (found == mMasterLists.end())
+                continue;
+            current.mBuckets.push_back(&(*found).second);
+            weights.push_back((mWeighting == WEIGHT_SIZE) ? double((*found).second.size()) : 1.0);
+        }
+
+        // Vose's alias method: scale weights to a mean of 1, then pair
+        // each short column with a long one that tops it up.
+        size_t count(weights.size());
+        double total(0.0);
+        for (double weight : weights)
+            total += weight;
+
+        current.mThreshold.assign(count, uint64_t(1) << 32);
+        current.mAlias.resize(count);
+
+        std::vector<size_t> small;
+        std::vector<size_t> large;
+        for (size_t i = 0; i < count; ++i)
+        {
+            weights[i] = weights[i] * count / total;
+            current.mAlias[i] = uint32_t(i);
+            (weights[i] < 1.0 ? small : large).push_back(i);
+        }
 
-    for (int i = 0; i < difficulty; ++i)
+        while (!small.empty() && !large.empty())
+        {
+            size_t less(small.back());
+            size_t more(large.back());
+            small.pop_back();
+
+            current.mThreshold[less] = uint64_t(weights[less] * double(uint64_t(1) << 32));
+            current.mAlias[less] = uint32_t(more);
+
+            weights[more] -= (1.0 - weights[less]);
+            if (weights[more] < 1.0)
+            {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // Whatever is left is 1 give or take rounding and keeps its column.
+    }
+
+    // Short dictionaries leave tiers empty, borrow the nearest easier
+    // tier, or a harder one if there is none.
+    for (int difficulty = 0; difficulty < 3; ++difficulty)
     {
-        for (int j = 0; j < ranges[i]; ++j)
-            ++itset;
+        mTierFor[difficulty] = difficulty;
+        for (int step = 1; mTiers[mTierFor[difficulty]].mBuckets.empty() && (step < 3); ++step)
+        {
+            if ((difficulty - step >= 0) && !mTiers[difficulty - step].mBuckets.empty())
+                mTierFor[difficulty] = difficulty - step;
+            else if ((difficulty + step < 3) && !mTiers[difficulty + step].mBuckets.empty())
+                mTierFor[difficulty] = difficulty + step;
+        }
     }
+}
 
-    int pick = std::rand() % ranges[difficulty];
-    while (pick--)
+void FalloutWords::dump()
+{
+    for (const auto &it : mMasterLists)
     {
-        ++itset;
+        std::cerr << "Size: " << it.first << " count: " << it.second.size() << std::endl <<
+            "===================================" << std::endl;
+
+        for (size_t i = 0; i < it.second.size(); ++i)
+        {
+            std::cerr << it.second[i] << " ";
+        }
+        std::cerr << std::endl << "===================================" << std::endl << std::endl;
     }
+}
+//------------------------------------------------------------------------
+const WordBucket & FalloutWords::selectWordSet(int difficulty, random_t &random) const
+{
+    if (!difficulty)
+        difficulty = random() % 3;
+    else 
+        difficulty -= 1;
+
+    static const WordBucket empty;
+
+    const Tier &tier(mTiers[mTierFor[std::min(std::max(difficulty, 0), 2)]]);
+    if (tier.mBuckets.empty())
+        return empty;
+
+    size_t column(random() % tier.mBuckets.size());
+    if (uint64_t(random()) >= tier.mThreshold[column])
+        column = tier.mAlias[column];
 
-    return (*itset).second;
+    return *tier.mBuckets[column];
 }
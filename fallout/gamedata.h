@@ -4,31 +4,91 @@
 #ifndef FALLOUT_GAMEDATA_H
 #define FALLOUT_GAMEDATA_H
 
+#include <array>
+#include <functional>
+#include <cstdint>
 #include <memory>
 #include <vector>
-#include <set>
 #include <map>
+#include <random>
+#include <string>
+
+#include "memoryaccount.h"
+#include "wordbucket.h"
 
 class FalloutWords
 {
 public:
     typedef std::shared_ptr<FalloutWords>   ptr_t;
-    typedef std::vector<std::string>    string_vec_t;
-    typedef std::set<std::string>       string_set_t;
+    typedef std::mt19937                random_t;
+
+    /// Told the running word count as a load goes, on the loading thread.
+    /// Returning false abandons the load.
+    typedef std::function<bool(size_t words)>   progress_t;
+
+    /// How a word length is chosen within a difficulty tier.
+    enum TierWeighting
+    {
+        WEIGHT_UNIFORM,     // every length equally likely
+        WEIGHT_SIZE         // in proportion to the words of that length
+    };
 
-    FalloutWords()
+    FalloutWords(TierWeighting weighting = WEIGHT_UNIFORM):
+        mMasterLists(),
+        mWeighting(weighting),
+        mTiers(),
+        mTierFor()
     {}
 
     ~FalloutWords()
     {}
 
-    bool                loadWordList(const std::string &filename);
+    // mTiers points into mMasterLists.
+    FalloutWords(const FalloutWords &) = delete;
+    FalloutWords &operator=(const FalloutWords &) = delete;
+
+    bool                loadWordList(const std::string &filename, bool verbose = true,
+                            const progress_t &progress = progress_t());
+
+    /// A dictionary of its own from the buckets read so far that are big
+    /// enough to play, or null until difficulty (1-3, 0 for any) has
+    /// words of its own.  Only from the loading thread, for instance in
+    /// a progress callback.
+    ptr_t               copyPlayable(int difficulty) const;
     void                dump();
-    const string_set_t &selectWordSet(int difficulty) const;
 
-    typedef std::map<size_t, string_set_t> string_length_map_t;
+    bool                isPlayable() const { return !mMasterLists.empty(); }
+
+    /// Every dictionary's words, and the scratch used to load them.  A
+    /// load that would go over its budget fails.
+    static MemoryAccount &  getMemory();
+    TierWeighting       getTierWeighting() const { return mWeighting; }
+
+    /// Words of one length for difficulty 1-3, or 0 for any.  Empty if
+    /// the dictionary is.
+    const WordBucket &  selectWordSet(int difficulty, random_t &random) const;
+
+    // Each bucket holds unique words of one length, sorted.
+    typedef std::map<size_t, WordBucket> string_length_map_t;
 
     string_length_map_t mMasterLists;
+
+private:
+    // Buckets of one difficulty with a Vose alias table over them, so a
+    // weighted pick costs two random numbers whatever the bucket count.
+    struct Tier
+    {
+        std::vector<const WordBucket *>     mBuckets;
+        std::vector<uint64_t>               mThreshold;     // out of 2^32
+        std::vector<uint32_t>               mAlias;
+    };
+
+    bool                readWordList(const std::string &filename, bool verbose, const progress_t &progress);
+    void                buildTiers(const string_length_map_t &layout);
+
+    TierWeighting       mWeighting;
+    std::array<Tier, 3> mTiers;
+    std::array<int, 3>  mTierFor;   // difficulty to a tier with buckets
 };
 
 #endif // !FALLOUT_GAMEDATA_H
@@ -0,0 +1,209 @@
+/**
+ */
+
+#include "inputsource.h"
+#include <iostream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <curses.h>
+
+//========================================================================
+namespace
+{
+    struct KeyName
+    {
+        const char *    mName;
+        int             mKey;
+    };
+
+    const KeyName KEY_NAMES[] = {
+        { "UP",     KEY_UP },
+        { "DOWN",   KEY_DOWN },
+        { "LEFT",   KEY_LEFT },
+        { "RIGHT",  KEY_RIGHT },
+        { "PGUP",   KEY_PPAGE },
+        { "PGDN",   KEY_NPAGE },
+        { "ENTER",  '\n' },
+        { "ENTER",  KEY_ENTER },
+        { "ESC",    0x1b },
+        { "SPACE",  ' ' }
+    };
+}
+
+//========================================================================
+const int InputSource::sEndOfInput(-2);
+
+//========================================================================
+RecordingInput::RecordingInput(const InputSource::ptr_t &source):
+    mSource(source),
+    mFile()
+{
+}
+
+bool RecordingInput::open(const std::string &filename, unsigned int seed)
+{
+    mFile.open(filename, std::ios::out | std::ios::app);
+    if (mFile.fail())
+    {
+        std::cerr << "Unable to open \"" << filename << "\" for recording" << std::endl;
+        return false;
+    }
+
+    mFile << "seed " << seed << std::endl;
+    return true;
+}
+
+int RecordingInput::readKey()
+{
+    int key(mSource->readKey());
+
+    if ((key != ERR) && (key != sEndOfInput) && mFile.is_open())
+        mFile << ScriptInput::keyName(key) << std::endl;
+
+    return key;
+}
+
+//========================================================================
+ScriptInput::ScriptInput():
+    mSession(nullptr),
+    mPosition(0),
+    mTiming(false),
+    mLastKey(),
+    mLatencies()
+{
+}
+
+void ScriptInput::reset(const ScriptSession &session)
+{
+    mSession = &session;
+    mPosition = 0;
+    mTiming = false;
+    mLatencies.clear();
+    mLatencies.reserve(session.mKeys.size());
+}
+
+int ScriptInput::readKey()
+{
+    finish();
+
+    if (!mSession || (mPosition >= mSession->mKeys.size()))
+        return sEndOfInput;
+
+    mTiming = true;
+    mLastKey = clock_t::now();
+    return mSession->mKeys[mPosition++];
+}
+
+void ScriptInput::finish()
+{
+    if (mTiming)
+        mLatencies.push_back(clock_t::now() - mLastKey);
+    mTiming = false;
+}
+
+//------------------------------------------------------------------------
+bool ScriptInput::parseScript(std::istream &input, const std::string &source, ScriptSession::vec_t &sessions)
+{
+    std::string line;
+    size_t line_number(0);
+    bool in_session(false);
+
+    while (std::getline(input, line))
+    {
+        ++line_number;
+
+        size_t comment(line.find('#'));
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string token;
+        while (tokens >> token)
+        {
+            if (token == "seed")
+            {
+                std::string value;
+                if (!(tokens >> value) || !std::isdigit(static_cast<unsigned char>(value[0])))
+                {
+                    std::cerr << source << ":" << line_number << ": seed needs a number" << std::endl;
+                    return false;
+                }
+
+                ScriptSession session;
+                session.mSource = source;
+                session.mSeed = static_cast<unsigned int>(std::strtoul(value.c_str(), nullptr, 10));
+                sessions.push_back(session);
+                in_session = true;
+                continue;
+            }
+
+            int key(0);
+            if (!parseKeyName(token, key))
+            {
+                std::cerr << source << ":" << line_number << ": unknown key \"" << token << "\"" << std::endl;
+                return false;
+            }
+
+            if (!in_session)
+            {   // keys before any seed line replay against seed 0
+                ScriptSession session;
+                session.mSource = source;
+                session.mSeed = 0;
+                sessions.push_back(session);
+                in_session = true;
+            }
+            sessions.back().mKeys.push_back(key);
+        }
+    }
+
+    return true;
+}
+
+bool ScriptInput::parseKeyName(const std::string &name, int &key)
+{
+    for (const KeyName &entry : KEY_NAMES)
+    {
+        if (name == entry.mName)
+        {
+            key = entry.mKey;
+            return true;
+        }
+    }
+
+    if ((name.size() == 1) && std::isgraph(static_cast<unsigned char>(name[0])))
+    {
+        key = static_cast<unsigned char>(name[0]);
+        return true;
+    }
+
+    if ((name.size() > 2) && (name.compare(0, 2, "0x") == 0))
+    {
+        char *end(nullptr);
+        long value(std::strtol(name.c_str() + 2, &end, 16));
+        if (!*end && (value > 0) && (value <= KEY_MAX))
+        {
+            key = static_cast<int>(value);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string ScriptInput::keyName(int key)
+{
+    for (const KeyName &entry : KEY_NAMES)
+    {
+        if (key == entry.mKey)
+            return entry.mName;
+    }
+
+    if ((key > 0) && (key < 0x80) && std::isgraph(key) && (key != '#'))
+        return std::string(1, static_cast<char>(key));
+
+    // Anything else, so a recording replays every key that was pressed.
+    std::ostringstream code;
+    code << "0x" << std::hex << key;
+    return code.str();
+}
@@ -0,0 +1,112 @@
+/**
+ */
+
+#ifndef FALLOUT_INPUTSOURCE_H
+#define FALLOUT_INPUTSOURCE_H
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <fstream>
+#include <chrono>
+
+#include "renderer.h"
+
+//========================================================================
+// Where GameBoard gets its keys from.
+class InputSource
+{
+public:
+    typedef std::shared_ptr<InputSource> ptr_t;
+
+    /// Returned by readKey() once a source has nothing more to give.
+    static const int        sEndOfInput;
+
+    virtual                 ~InputSource() {}
+
+    /// Next key, ERR if none arrived in time, or sEndOfInput.
+    virtual int             readKey() = 0;
+};
+
+//========================================================================
+// Keys typed at the terminal the renderer owns.
+class TerminalInput : public InputSource
+{
+public:
+    TerminalInput(const Renderer::ptr_t &renderer):
+        mRenderer(renderer)
+    {}
+
+    virtual int             readKey() override { return mRenderer->readKey(); }
+
+private:
+    Renderer::ptr_t         mRenderer;
+};
+
+//========================================================================
+// Passes keys through from another source and writes them to a file in
+// script format so the session can be replayed with --script.
+class RecordingInput : public InputSource
+{
+public:
+                            RecordingInput(const InputSource::ptr_t &source);
+
+    bool                    open(const std::string &filename, unsigned int seed);
+
+    virtual int             readKey() override;
+
+private:
+    InputSource::ptr_t      mSource;
+    std::ofstream           mFile;
+};
+
+//========================================================================
+// One recorded session: the seed its boards were generated from and the
+// keys that were pressed.
+struct ScriptSession
+{
+    typedef std::vector<ScriptSession>  vec_t;
+
+    std::string             mSource;
+    unsigned int            mSeed;
+    std::vector<int>        mKeys;
+};
+
+//========================================================================
+// Replays a ScriptSession as fast as GameBoard will take the keys.  The
+// time between one readKey() and the next is the time the board spent
+// handling the previous key, which is reported as its latency.  The last
+// key has no next read, finish() times it once the session is over.
+class ScriptInput : public InputSource
+{
+public:
+    typedef std::chrono::steady_clock   clock_t;
+
+                            ScriptInput();
+
+    void                    reset(const ScriptSession &session);
+
+    virtual int             readKey() override;
+    void                    finish();
+
+    size_t                  getKeyCount() const     { return mLatencies.size(); }
+    const std::vector<clock_t::duration> &getLatencies() const { return mLatencies; }
+
+    /// Parse script text.  Each "seed <n>" line starts a new session,
+    /// other tokens are key names (UP, DOWN, LEFT, RIGHT, ENTER, ESC),
+    /// single characters or key codes in hex (0x104).  '#' starts a
+    /// comment.
+    static bool             parseScript(std::istream &input, const std::string &source, ScriptSession::vec_t &sessions);
+    static bool             parseKeyName(const std::string &name, int &key);
+    static std::string      keyName(int key);
+
+private:
+    const ScriptSession *   mSession;
+    size_t                  mPosition;
+    bool                    mTiming;
+    clock_t::time_point     mLastKey;
+    std::vector<clock_t::duration> mLatencies;
+};
+
+#endif // !FALLOUT_INPUTSOURCE_H
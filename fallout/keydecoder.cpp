@@ -0,0 +1,113 @@
+/**
+ */
+
+#include "keydecoder.h"
+#include <algorithm>
+#include <cstring>
+#include <curses.h>
+
+//========================================================================
+namespace
+{
+    const char KEY_ESC(0x1b);
+
+    int decode_final(char final)
+    {
+        switch (final)
+        {
+        case 'A':   return KEY_UP;
+        case 'B':   return KEY_DOWN;
+        case 'C':   return KEY_RIGHT;
+        case 'D':   return KEY_LEFT;
+        case 'H':   return KEY_HOME;
+        case 'F':   return KEY_END;
+        default:    return 0;
+        }
+    }
+
+    int decode_tilde(int parameter)
+    {
+        switch (parameter)
+        {
+        case 1:     return KEY_HOME;
+        case 4:     return KEY_END;
+        case 5:     return KEY_PPAGE;
+        case 6:     return KEY_NPAGE;
+        default:    return 0;
+        }
+    }
+}
+
+//========================================================================
+void KeyDecoder::push(const char *data, size_t length)
+{
+    length = std::min(length, mBuffer.size() - mLength);
+    std::memcpy(mBuffer.data() + mLength, data, length);
+    mLength += length;
+}
+
+int KeyDecoder::next(bool flush_escape)
+{
+    while (mLength)
+    {
+        char first(mBuffer[0]);
+
+        if (first != KEY_ESC)
+        {
+            consume(1);
+            if (first == '\r')
+                return '\n';
+            return static_cast<unsigned char>(first);
+        }
+
+        if (mLength == 1)
+        {
+            if (!flush_escape)
+                return ERR;
+            consume(1);
+            return KEY_ESC;
+        }
+
+        char introducer(mBuffer[1]);
+        if ((introducer != '[') && (introducer != 'O'))
+        {   // ESC followed by an ordinary key.
+            consume(1);
+            return KEY_ESC;
+        }
+
+        // CSI/SS3: parameters then a final byte in 0x40-0x7E.
+        size_t end(2);
+        int parameter(0);
+        while ((end < mLength) && ((mBuffer[end] < 0x40) || (mBuffer[end] > 0x7E)))
+        {
+            if ((mBuffer[end] >= '0') && (mBuffer[end] <= '9'))
+                parameter = (parameter * 10) + (mBuffer[end] - '0');
+            ++end;
+        }
+
+        if (end >= mLength)
+        {
+            if (!flush_escape)
+                return ERR;
+            consume(1);
+            return KEY_ESC;
+        }
+
+        char final(mBuffer[end]);
+        consume(end + 1);
+
+        int key((final == '~') ? decode_tilde(parameter) : decode_final(final));
+        if (key)
+            return key;
+        // Unrecognised sequence, drop it and keep looking.
+    }
+
+    return ERR;
+}
+
+void KeyDecoder::consume(size_t count)
+{
+    count = std::min(count, mLength);
+    std::memmove(mBuffer.data(), mBuffer.data() + count, mLength - count);
+    mLength -= count;
+}
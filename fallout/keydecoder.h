@@ -0,0 +1,39 @@
+/**
+ */
+
+#ifndef FALLOUT_KEYDECODER_H
+#define FALLOUT_KEYDECODER_H
+
+#include <array>
+#include <cstddef>
+
+//========================================================================
+// Turns raw terminal bytes into the curses key codes GameBoard expects
+// (KEY_UP, KEY_LEFT, ...).  Used wherever input does not come through
+// curses itself.
+class KeyDecoder
+{
+public:
+    KeyDecoder():
+        mBuffer(),
+        mLength(0)
+    {}
+
+    /// Append raw input.  Bytes that do not fit are dropped.
+    void                push(const char *data, size_t length);
+
+    /// Next decoded key or ERR if nothing complete is buffered.  With
+    /// flush_escape a partial escape sequence is given up on and the
+    /// ESC is returned on its own.
+    int                 next(bool flush_escape = false);
+
+    bool                isPending() const { return (mLength > 0); }
+
+private:
+    void                consume(size_t count);
+
+    std::array<char, 64>    mBuffer;
+    size_t                  mLength;
+};
+
+#endif // !FALLOUT_KEYDECODER_H
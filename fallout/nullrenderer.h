@@ -0,0 +1,51 @@
+/**
+ */
+
+#ifndef FALLOUT_NULLRENDERER_H
+#define FALLOUT_NULLRENDERER_H
+
+#include <curses.h>
+
+#include "renderer.h"
+
+//========================================================================
+// Renders nothing and has no terminal.  Used for headless runs where
+// only the game logic matters.
+class NullRenderer : public Renderer
+{
+public:
+    virtual RenderPanel::ptr_t  createPanel(int height, int width, int, int, bool) override
+    {
+        return std::make_shared<NullPanel>(height, width);
+    }
+
+    virtual void            flush() override    {}
+    virtual void            beep() override     {}
+    virtual int             readKey() override  { return ERR; }
+
+private:
+    class NullPanel : public RenderPanel
+    {
+    public:
+        NullPanel(int height, int width):
+            mHeight(height),
+            mWidth(width)
+        {}
+
+        virtual int getWidth() const override   { return mWidth; }
+        virtual int getHeight() const override  { return mHeight; }
+
+        virtual void clear() override                       {}
+        virtual void move(int, int) override                {}
+        virtual void getCursor(int &y, int &x) const override { y = 0; x = 0; }
+        virtual void write(const char *, int, int) override {}
+        virtual void clearToEol() override                  {}
+        virtual void refresh() override                     {}
+
+    private:
+        int     mHeight;
+        int     mWidth;
+    };
+};
+
+#endif // !FALLOUT_NULLRENDERER_H
@@ -0,0 +1,65 @@
+/**
+ */
+
+#ifndef FALLOUT_RENDERER_H
+#define FALLOUT_RENDERER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+//========================================================================
+// A rectangular region of the terminal.  Text written to a panel wraps
+// at its right edge and, for scrolling panels, scrolls at the bottom,
+// the same way a curses window created with scrollok() would.
+class RenderPanel
+{
+public:
+    typedef std::shared_ptr<RenderPanel> ptr_t;
+
+    enum Attribute
+    {
+        ATTR_NORMAL = 0,
+        ATTR_REVERSE = 1
+    };
+
+    virtual                 ~RenderPanel() {}
+
+    virtual int             getWidth() const = 0;
+    virtual int             getHeight() const = 0;
+
+    virtual void            clear() = 0;
+    virtual void            move(int y, int x) = 0;
+    virtual void            getCursor(int &y, int &x) const = 0;
+    virtual void            write(const char *text, int length, int attr = ATTR_NORMAL) = 0;
+    virtual void            clearToEol() = 0;
+
+    /// Mark the panel's changes as ready for the next Renderer::flush().
+    virtual void            refresh() = 0;
+
+    void                    write(std::string_view text, int attr = ATTR_NORMAL)
+    {
+        write(text.data(), (int)text.size(), attr);
+    }
+};
+
+//========================================================================
+// Owns the terminal.  Panels are staged independently and pushed to the
+// terminal together by flush().
+class Renderer
+{
+public:
+    typedef std::shared_ptr<Renderer> ptr_t;
+
+    virtual                 ~Renderer() {}
+
+    virtual RenderPanel::ptr_t  createPanel(int height, int width, int y, int x, bool scrolling) = 0;
+
+    virtual void            flush() = 0;
+    virtual void            beep() = 0;
+
+    /// Wait up to a second for a key.  Returns ERR if none arrived.
+    virtual int             readKey() = 0;
+};
+
+#endif // !FALLOUT_RENDERER_H
@@ -0,0 +1,86 @@
+/**
+ */
+
+#include "sessionloop.h"
+#include "inputsource.h"
+
+//========================================================================
+SessionLoop::SessionLoop():
+    mSessions(),
+    mActive(0),
+    mMutex(),
+    mWake(),
+    mQueue(),
+    mClosed(false)
+{
+}
+
+size_t SessionLoop::add(SessionTask task, KeyChannel &keys)
+{
+    if (!task.done())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mActive;
+    }
+
+    mSessions.push_back(Session{ std::move(task), &keys });
+    return mSessions.size() - 1;
+}
+
+void SessionLoop::post(size_t session, int key)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(Event{ session, key });
+    }
+    mWake.notify_one();
+}
+
+void SessionLoop::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mClosed = true;
+    }
+    mWake.notify_one();
+}
+
+void SessionLoop::run(const observer_t &observer)
+{
+    std::vector<Event> batch;
+
+    while (true)
+    {
+        {   // take everything queued so far, posting threads only wait
+            // for the swap and never for a session
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this] { return !mQueue.empty() || mClosed || !mActive; });
+            if (mQueue.empty())
+                break;
+            batch.swap(mQueue);
+        }
+
+        size_t finished(0);
+        for (const Event &event : batch)
+        {
+            if (event.mSession >= mSessions.size())
+                continue;
+
+            Session &session(mSessions[event.mSession]);
+            if (session.mTask.done())
+                continue;
+
+            clock_t::time_point start(clock_t::now());
+            session.mKeys->push(event.mKey);
+            if (observer && (event.mKey != InputSource::sEndOfInput))
+                observer(clock_t::now() - start);
+
+            if (session.mTask.done())
+                ++finished;
+        }
+        batch.clear();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive -= finished;
+    }
+}
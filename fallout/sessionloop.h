@@ -0,0 +1,72 @@
+/**
+ */
+
+#ifndef FALLOUT_SESSIONLOOP_H
+#define FALLOUT_SESSIONLOOP_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "sessiontask.h"
+
+//========================================================================
+// Drives many suspended sessions from one thread.  Input from any
+// thread is posted as (session, key) events, and run() resumes each
+// session only when one of its keys comes up, so a board costs nothing
+// while its player is thinking.
+class SessionLoop
+{
+public:
+    typedef std::chrono::steady_clock   clock_t;
+
+    /// Called after every key with the time the session took on it, the
+    /// end of a session's input is not a key and is not timed.
+    typedef std::function<void(clock_t::duration)> observer_t;
+
+    SessionLoop();
+
+    /// Register a started session and the channel it waits on, returns
+    /// the id to post its keys to.  Only from the thread calling run().
+    size_t                  add(SessionTask task, KeyChannel &keys);
+
+    /// Queue a key for a session, from any thread.  Keys for a session
+    /// that has finished are dropped.
+    void                    post(size_t session, int key);
+
+    /// No more keys are coming, run() returns once the queue is empty.
+    void                    close();
+
+    /// Handle events until every session has finished or the loop is
+    /// closed and drained.
+    void                    run(const observer_t &observer = observer_t());
+
+    size_t                  getSessionCount() const     { return mSessions.size(); }
+    size_t                  getActiveCount() const      { return mActive; }
+    const SessionTask &     getSession(size_t session) const { return mSessions[session].mTask; }
+
+private:
+    struct Session
+    {
+        SessionTask         mTask;
+        KeyChannel *        mKeys;
+    };
+
+    struct Event
+    {
+        size_t              mSession;
+        int                 mKey;
+    };
+
+    std::vector<Session>    mSessions;
+    size_t                  mActive;
+
+    std::mutex              mMutex;
+    std::condition_variable mWake;
+    std::vector<Event>      mQueue;
+    bool                    mClosed;
+};
+
+#endif // !FALLOUT_SESSIONLOOP_H
@@ -0,0 +1,45 @@
+/**
+ */
+
+#include "sessiontask.h"
+#include <new>
+
+//========================================================================
+namespace
+{
+    // The last frame freed on this thread, kept for the next session.
+    // Every session has the same frame size, so one slot covers the
+    // common case of playing boards one after another.
+    struct FrameCache
+    {
+        ~FrameCache()       { ::operator delete(mFrame); }
+
+        void *      mFrame = nullptr;
+        size_t      mSize = 0;
+    };
+
+    thread_local FrameCache sFrameCache;
+}
+
+//========================================================================
+void *SessionTask::promise_type::operator new(size_t size)
+{
+    FrameCache &cache(sFrameCache);
+    if (cache.mFrame && (cache.mSize == size))
+        return std::exchange(cache.mFrame, nullptr);
+
+    return ::operator new(size);
+}
+
+void SessionTask::promise_type::operator delete(void *frame, size_t size)
+{
+    FrameCache &cache(sFrameCache);
+    if (!cache.mFrame)
+    {
+        cache.mFrame = frame;
+        cache.mSize = size;
+        return;
+    }
+
+    ::operator delete(frame);
+}
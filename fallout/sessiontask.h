@@ -0,0 +1,125 @@
+/**
+ */
+
+#ifndef FALLOUT_SESSIONTASK_H
+#define FALLOUT_SESSIONTASK_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+//========================================================================
+// Where a suspended session waits for its next key.  Whoever owns the
+// input pushes keys in, and the session is resumed on the pushing
+// thread.  Holds at most one key, a session always handles a key before
+// it asks for the next one.
+class KeyChannel
+{
+public:
+    class Awaiter
+    {
+    public:
+        explicit Awaiter(KeyChannel &channel): mChannel(channel) {}
+
+        bool        await_ready() const noexcept    { return mChannel.mHasKey; }
+        void        await_suspend(std::coroutine_handle<> waiter) noexcept { mChannel.mWaiter = waiter; }
+        int         await_resume() noexcept
+        {
+            mChannel.mHasKey = false;
+            return mChannel.mKey;
+        }
+
+    private:
+        KeyChannel &mChannel;
+    };
+
+    KeyChannel():
+        mWaiter(),
+        mKey(0),
+        mHasKey(false)
+    {}
+
+    KeyChannel(const KeyChannel &) = delete;
+    KeyChannel &operator=(const KeyChannel &) = delete;
+
+    /// co_await next() suspends until push() is called.
+    Awaiter                 next()              { return Awaiter(*this); }
+
+    bool                    isWaiting() const   { return bool(mWaiter); }
+
+    void                    push(int key)
+    {
+        mKey = key;
+        mHasKey = true;
+        if (mWaiter)
+            std::exchange(mWaiter, nullptr).resume();
+    }
+
+private:
+    std::coroutine_handle<> mWaiter;
+    int                     mKey;
+    bool                    mHasKey;
+};
+
+//========================================================================
+// A game session running as a coroutine.  It starts eagerly, runs up to
+// the first key it waits for and yields whether the last board was won.
+// Frames are recycled per thread, so starting one session after another
+// does not touch the heap.
+class SessionTask
+{
+public:
+    struct promise_type
+    {
+        SessionTask         get_return_object()
+        {
+            return SessionTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never  initial_suspend() noexcept  { return {}; }
+        std::suspend_always final_suspend() noexcept    { return {}; }
+
+        void                return_value(bool win)      { mWin = win; }
+        void                unhandled_exception()       { mException = std::current_exception(); }
+
+        static void *       operator new(size_t size);
+        static void         operator delete(void *frame, size_t size);
+
+        bool                mWin = false;
+        std::exception_ptr  mException;
+    };
+
+    SessionTask(): mHandle() {}
+    SessionTask(SessionTask &&other) noexcept: mHandle(std::exchange(other.mHandle, nullptr)) {}
+    ~SessionTask()          { if (mHandle) mHandle.destroy(); }
+
+    SessionTask &operator=(SessionTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (mHandle)
+                mHandle.destroy();
+            mHandle = std::exchange(other.mHandle, nullptr);
+        }
+        return *this;
+    }
+
+    bool                    valid() const   { return bool(mHandle); }
+    bool                    done() const    { return !mHandle || mHandle.done(); }
+
+    /// Only once done(), rethrows anything the session threw.
+    bool                    result() const
+    {
+        if (mHandle.promise().mException)
+            std::rethrow_exception(mHandle.promise().mException);
+        return mHandle.promise().mWin;
+    }
+
+private:
+    explicit SessionTask(std::coroutine_handle<promise_type> handle): mHandle(handle) {}
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+#endif // !FALLOUT_SESSIONTASK_H
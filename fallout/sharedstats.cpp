@@ -0,0 +1,141 @@
+/**
+ */
+
+#include "sharedstats.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//========================================================================
+namespace
+{
+    const char STATS_MAGIC[8] = { 'F', 'O', 'S', 'T', 'A', 'T', 'S', '\0' };
+
+    /// Map and validate a stats file, a writable one is created and
+    /// initialized if it is new.  The flock only covers creation, two
+    /// kiosks starting together must not both see an empty file.
+    StatsFileLayout *map_stats(const std::string &filename, bool writable)
+    {
+        int fd(::open(filename.c_str(), (writable ? (O_RDWR | O_CREAT) : O_RDONLY) | O_CLOEXEC, 0666));
+        if (fd < 0)
+        {
+            std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+            return nullptr;
+        }
+
+        flock(fd, LOCK_EX);
+
+        struct stat info;
+        bool valid(fstat(fd, &info) == 0);
+        if (valid && writable && !info.st_size)
+        {
+            StatsFileLayout header;
+            std::memset(static_cast<void *>(&header), 0, sizeof(header));
+            std::memcpy(header.mMagic, STATS_MAGIC, sizeof(header.mMagic));
+            header.mVersion = StatsFileLayout::sVersion;
+
+            valid = (pwrite(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)));
+            info.st_size = sizeof(header);
+        }
+
+        void *map(MAP_FAILED);
+        if (valid && (size_t(info.st_size) == sizeof(StatsFileLayout)))
+            map = mmap(nullptr, sizeof(StatsFileLayout), writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                MAP_SHARED, fd, 0);
+
+        flock(fd, LOCK_UN);
+        close(fd);
+
+        if (map == MAP_FAILED)
+        {
+            std::cerr << "\"" << filename << "\" is not a stats file" << std::endl;
+            return nullptr;
+        }
+
+        StatsFileLayout *stats(static_cast<StatsFileLayout *>(map));
+        if (std::memcmp(stats->mMagic, STATS_MAGIC, sizeof(STATS_MAGIC)) ||
+            (stats->mVersion != StatsFileLayout::sVersion))
+        {
+            std::cerr << "\"" << filename << "\" is not a compatible stats file" << std::endl;
+            munmap(map, sizeof(StatsFileLayout));
+            return nullptr;
+        }
+
+        return stats;
+    }
+}
+
+//========================================================================
+SharedStats::SharedStats():
+    mStats(nullptr)
+{
+}
+
+SharedStats::~SharedStats()
+{
+    if (mStats)
+        munmap(mStats, sizeof(StatsFileLayout));
+}
+
+bool SharedStats::open(const std::string &filename)
+{
+    if (mStats)
+        munmap(mStats, sizeof(StatsFileLayout));
+
+    mStats = map_stats(filename, true);
+    return mStats != nullptr;
+}
+
+void SharedStats::addGame(int difficulty, bool win, duration_t played)
+{
+    int index(std::min(std::max(difficulty, 0), StatsFileLayout::sDifficulties - 1));
+
+    add(mStats->mGames[index]);
+    if (win)
+        add(mStats->mWins[index]);
+    add(mStats->mPlayNanoseconds,
+        uint64_t(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(played).count())));
+}
+
+//------------------------------------------------------------------------
+bool SharedStats::dump(const std::string &filename, std::ostream &out)
+{
+    StatsFileLayout *stats(map_stats(filename, false));
+    if (!stats)
+        return false;
+
+    auto get([](const StatsFileLayout::counter_t &counter) { return counter.load(std::memory_order_relaxed); });
+
+    uint64_t games(0);
+    uint64_t wins(0);
+    for (int i = 0; i < StatsFileLayout::sDifficulties; ++i)
+    {
+        games += get(stats->mGames[i]);
+        wins += get(stats->mWins[i]);
+    }
+
+    double seconds(get(stats->mPlayNanoseconds) / 1e9);
+    out << std::fixed << std::setprecision(3) <<
+        "Sessions:         " << get(stats->mSessions) << std::endl <<
+        "Games:            " << games << " (" << wins << " won)" << std::endl;
+    for (int i = 1; i < StatsFileLayout::sDifficulties; ++i)
+    {
+        out << "  Difficulty " << i << ":    " << get(stats->mGames[i]) << " (" <<
+            get(stats->mWins[i]) << " won)" << std::endl;
+    }
+    out <<
+        "Guesses:          " << get(stats->mGuesses) << std::endl <<
+        "Duds removed:     " << get(stats->mDudsRemoved) << std::endl <<
+        "Decoys removed:   " << get(stats->mDecoysRemoved) << std::endl <<
+        "Turn resets:      " << get(stats->mTurnResets) << std::endl <<
+        "Average game:     " << (games ? (seconds / games) : 0.0) << " s" << std::endl;
+
+    munmap(stats, sizeof(StatsFileLayout));
+    return true;
+}
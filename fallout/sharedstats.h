@@ -0,0 +1,76 @@
+/**
+ */
+
+#ifndef FALLOUT_SHAREDSTATS_H
+#define FALLOUT_SHAREDSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+//========================================================================
+// File layout of the shared statistics, native endian.  The counters
+// are lock-free atomics used in place through a shared mapping, so
+// every process on the host that maps the file adds to the same totals.
+struct StatsFileLayout
+{
+    typedef std::atomic<uint64_t>   counter_t;
+
+    static const uint32_t   sVersion = 1;
+    static const int        sDifficulties = 4;  // 0 is unused, boards are 1-3
+
+    char                    mMagic[8];          // "FOSTATS\0"
+    uint32_t                mVersion;
+    uint32_t                mReserved;
+
+    counter_t               mSessions;
+    counter_t               mGames[sDifficulties];
+    counter_t               mWins[sDifficulties];
+    counter_t               mGuesses;
+    counter_t               mDudsRemoved;
+    counter_t               mDecoysRemoved;
+    counter_t               mTurnResets;
+    counter_t               mPlayNanoseconds;   // summed over games
+};
+
+static_assert(StatsFileLayout::counter_t::is_always_lock_free,
+    "Shared counters need lock-free 64 bit atomics");
+
+//========================================================================
+// A stats file mapped read-write.  Updates are a relaxed atomic add on
+// shared memory, no locks and no system calls.
+class SharedStats
+{
+public:
+    typedef std::shared_ptr<SharedStats>    ptr_t;
+    typedef std::chrono::steady_clock::duration duration_t;
+
+    SharedStats();
+    ~SharedStats();
+
+    /// Map filename, creating it if needed.
+    bool                    open(const std::string &filename);
+
+    void                    addSession()                { add(mStats->mSessions); }
+    void                    addGuess()                  { add(mStats->mGuesses); }
+    void                    addDudRemoved()             { add(mStats->mDudsRemoved); }
+    void                    addDecoyRemoved()           { add(mStats->mDecoysRemoved); }
+    void                    addTurnReset()              { add(mStats->mTurnResets); }
+    void                    addGame(int difficulty, bool win, duration_t played);
+
+    /// Print the totals in filename.
+    static bool             dump(const std::string &filename, std::ostream &out);
+
+private:
+    static void             add(StatsFileLayout::counter_t &counter, uint64_t value = 1)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    StatsFileLayout *       mStats;
+};
+
+#endif // !FALLOUT_SHAREDSTATS_H
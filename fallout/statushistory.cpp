@@ -0,0 +1,120 @@
+/**
+ */
+
+#include "statushistory.h"
+#include <algorithm>
+
+//========================================================================
+StatusHistory::StatusHistory(int width, int capacity, std::pmr::memory_resource *memory):
+    mWidth(std::min(width, 255)),
+    mCapacity(std::max(capacity, 1)),
+    mText(size_t(mWidth) * mCapacity, memory),
+    mLength(mCapacity, memory),
+    mCurrent(0),
+    mPageStart(0),
+    mTop(0),
+    mBrowsing(false)
+{
+}
+
+void StatusHistory::append(std::string_view text)
+{
+    for (char ch : text)
+    {
+        size_t slot(mCurrent % mCapacity);
+
+        if ((ch != '\n') && (mLength[slot] < mWidth))
+        {
+            mText[(slot * mWidth) + mLength[slot]++] = ch;
+            continue;
+        }
+
+        // A new line reuses the oldest slot once the ring is full.
+        ++mCurrent;
+        slot = mCurrent % mCapacity;
+        mLength[slot] = 0;
+        if (ch != '\n')
+            mText[(slot * mWidth) + mLength[slot]++] = ch;
+    }
+}
+
+void StatusHistory::startPage()
+{
+    if (mLength[mCurrent % mCapacity])
+        append("\n");
+    mPageStart = mCurrent;
+}
+
+bool StatusHistory::scrollBack(int lines, int height)
+{
+    int64_t oldest(getOldest());
+    int64_t live_top(getLiveTop(height));
+
+    if (!mBrowsing)
+    {
+        // Leaving the live view shows every line, not just this page.
+        if ((lines <= 0) || (oldest >= live_top))
+            return false;
+        mBrowsing = true;
+        mTop = std::max(oldest, live_top - lines);
+        return true;
+    }
+
+    int64_t top(std::max(oldest, mTop - lines));
+    if (top >= live_top)
+    {
+        resetScroll();
+        return true;
+    }
+    if (top == mTop)
+        return false;
+    mTop = top;
+    return true;
+}
+
+//------------------------------------------------------------------------
+void StatusHistory::render(RenderPanel &panel) const
+{
+    int height(panel.getHeight());
+    int64_t top(mBrowsing ? mTop : getLiveTop(height));
+    int64_t first(mBrowsing ? getOldest() : std::max<int64_t>(mPageStart, getOldest()));
+
+    for (int row = 0; row < height; ++row)
+    {
+        int64_t line(top + row);
+
+        panel.move(row, 0);
+        if ((line < first) || (line > int64_t(mCurrent)))
+        {
+            panel.clearToEol();
+            continue;
+        }
+
+        std::string_view text(getLine(uint64_t(line)));
+        panel.write(text);
+        if (int(text.size()) < mWidth)
+            panel.clearToEol();
+    }
+
+    int length(mLength[mCurrent % mCapacity]);
+    panel.move(int(std::min<int64_t>(int64_t(mCurrent) - top, height - 1)), std::min(length, mWidth - 1));
+    panel.refresh();
+}
+
+//------------------------------------------------------------------------
+std::string_view StatusHistory::getLine(uint64_t line) const
+{
+    size_t slot(line % mCapacity);
+    return std::string_view(mText.data() + (slot * mWidth), mLength[slot]);
+}
+
+int64_t StatusHistory::getOldest() const
+{
+    return (mCurrent >= uint64_t(mCapacity)) ? int64_t(mCurrent - mCapacity + 1) : 0;
+}
+
+int64_t StatusHistory::getLiveTop(int height) const
+{
+    // The page fills from the top, then scrolls.
+    return std::max<int64_t>(mPageStart, int64_t(mCurrent) - (height - 1));
+}
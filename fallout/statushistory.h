@@ -0,0 +1,58 @@
+/**
+ */
+
+#ifndef FALLOUT_STATUSHISTORY_H
+#define FALLOUT_STATUSHISTORY_H
+
+#include "renderer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+//========================================================================
+// The lines written to the status panel over a whole session, kept in a
+// fixed ring so the oldest are dropped once it is full.  Text wraps at
+// the panel width the way the panel itself would.  The live view shows
+// the current page, which starts empty with each board, filling from
+// the top and then scrolling.  Scrolling back shows older lines,
+// including those of earlier boards.
+class StatusHistory
+{
+public:
+    StatusHistory(int width, int capacity,
+        std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+    /// Add text to the current line.  '\n' starts a new one.
+    void            append(std::string_view text);
+
+    /// Start a new page, the live view no longer shows what came before.
+    void            startPage();
+
+    /// Scroll lines towards older history (positive) or back towards the
+    /// live view (negative).  Returns false if the view did not move.
+    bool            scrollBack(int lines, int height);
+    void            resetScroll()           { mBrowsing = false; }
+    bool            isScrolled() const      { return mBrowsing; }
+
+    /// Draw the visible lines, leaving the panel's cursor at the end of
+    /// the current line.  Touches only panel.getHeight() rows.
+    void            render(RenderPanel &panel) const;
+
+private:
+    std::string_view    getLine(uint64_t line) const;
+    int64_t             getOldest() const;
+    int64_t             getLiveTop(int height) const;
+
+    int                 mWidth;
+    int                 mCapacity;
+    std::pmr::vector<char>      mText;      // mCapacity lines of mWidth
+    std::pmr::vector<uint8_t>   mLength;
+    uint64_t            mCurrent;       // line being written
+    uint64_t            mPageStart;
+    int64_t             mTop;           // first line shown while browsing
+    bool                mBrowsing;      // off the live view
+};
+
+#endif // !FALLOUT_STATUSHISTORY_H
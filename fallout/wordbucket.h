@@ -0,0 +1,71 @@
+/**
+ */
+
+#ifndef FALLOUT_WORDBUCKET_H
+#define FALLOUT_WORDBUCKET_H
+
+#include <algorithm>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//========================================================================
+// All the words of one length, packed back to back in one block with
+// no separators.  Once loading is done the block never moves, so boards
+// can hold string_views into it for as long as they hold the dictionary.
+// The block, and the scratch used to sort it, come from memory.
+class WordBucket
+{
+public:
+    explicit WordBucket(size_t length = 0, std::pmr::memory_resource *memory = std::pmr::get_default_resource()):
+        mLength(length),
+        mData(memory)
+    {}
+
+    WordBucket(const WordBucket &other, std::pmr::memory_resource *memory):
+        mLength(other.mLength),
+        mData(other.mData, memory)
+    {}
+
+    size_t              getWordLength() const   { return mLength; }
+    size_t              size() const            { return mLength ? (mData.size() / mLength) : 0; }
+    bool                empty() const           { return mData.empty(); }
+
+    std::string_view    operator[](size_t index) const
+    {
+        return std::string_view(mData.data() + (index * mLength), mLength);
+    }
+
+    /// word must be getWordLength() characters.
+    void                push_back(std::string_view word)
+    {
+        mData.append(word.data(), mLength);
+    }
+
+    void                sort()
+    {
+        std::pmr::vector<std::string_view> words(mData.get_allocator().resource());
+        words.reserve(size());
+        for (size_t i = 0; i < size(); ++i)
+        {
+            words.push_back((*this)[i]);
+        }
+        std::sort(words.begin(), words.end());
+
+        std::pmr::string sorted(mData.get_allocator());
+        sorted.reserve(mData.size());
+        for (std::string_view word : words)
+        {
+            sorted.append(word.data(), word.size());
+        }
+        mData.swap(sorted);
+        mData.shrink_to_fit();
+    }
+
+private:
+    size_t              mLength;
+    std::pmr::string    mData;
+};
+
+#endif // !FALLOUT_WORDBUCKET_H
@@ -0,0 +1,243 @@
+/**
+ */
+
+#include "wordlibrary.h"
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+namespace
+{
+    // Editors and deploy scripts tend to write in bursts, wait for the
+    // file to settle before reading it.
+    const int SETTLE_MS = 250;
+}
+
+//========================================================================
+WordLibrary::WordLibrary(const FalloutWords::ptr_t &words):
+    mWords(words),
+    mGeneration(0),
+    mPublishMutex(),
+    mFilename(),
+    mWatchName(),
+    mWatchError(),
+    mNotifyFd(-1),
+    mWakeFd(-1),
+    mThread(),
+    mLoader(),
+    mLoadMutex(),
+    mLoadChanged(),
+    mLoadedWords(0),
+    mLoadCancel(false),
+    mLoadPlayable(false),
+    mLoadDone(true),
+    mLoadSucceeded(true)
+{
+}
+
+WordLibrary::~WordLibrary()
+{
+    cancelLoading();
+    stopWatching();
+}
+
+void WordLibrary::publish(const FalloutWords::ptr_t &words)
+{
+    std::lock_guard<std::mutex> lock(mPublishMutex);
+    std::atomic_store(&mWords, words);
+    ++mGeneration;
+}
+
+bool WordLibrary::publishOver(const FalloutWords::ptr_t &words, unsigned &generation)
+{
+    std::lock_guard<std::mutex> lock(mPublishMutex);
+    if (mGeneration != generation)
+        return false;
+
+    std::atomic_store(&mWords, words);
+    generation = ++mGeneration;
+    return true;
+}
+
+//------------------------------------------------------------------------
+void WordLibrary::startLoading(const std::string &filename, int difficulty)
+{
+    finishLoading();
+
+    {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
+        mLoadPlayable = false;
+        mLoadDone = false;
+        mLoadSucceeded = false;
+    }
+    mLoadedWords = 0;
+    mLoadCancel = false;
+    mLoader = std::thread(&WordLibrary::loader, this, filename, difficulty);
+}
+
+bool WordLibrary::waitPlayable(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mLoadMutex);
+    return mLoadChanged.wait_for(lock, timeout, [this] { return mLoadPlayable || mLoadDone; });
+}
+
+bool WordLibrary::finishLoading()
+{
+    if (mLoader.joinable())
+        mLoader.join();
+
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    return mLoadSucceeded;
+}
+
+void WordLibrary::cancelLoading()
+{
+    mLoadCancel = true;
+    finishLoading();
+}
+
+void WordLibrary::loader(std::string filename, int difficulty)
+{
+    FalloutWords::ptr_t words(std::make_shared<FalloutWords>(snapshot()->getTierWeighting()));
+    unsigned generation(mGeneration);
+    bool early(false);
+
+    bool loaded(words->loadWordList(filename, false, [&](size_t count) {
+        mLoadedWords = count;
+        if (mLoadCancel)
+            return false;
+        if (early)
+            return true;
+
+        FalloutWords::ptr_t partial(words->copyPlayable(difficulty));
+        if (!partial)
+            return true;
+
+        // A watcher reload has published the whole file already.
+        publishOver(partial, generation);
+        early = true;
+
+        std::lock_guard<std::mutex> lock(mLoadMutex);
+        mLoadPlayable = true;
+        mLoadChanged.notify_all();
+        return true;
+    }));
+
+    bool playable(loaded && words->isPlayable());
+    if (playable)
+        publishOver(words, generation);
+
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    mLoadPlayable = mLoadPlayable || playable;
+    mLoadSucceeded = playable;
+    mLoadDone = true;
+    mLoadChanged.notify_all();
+}
+
+//------------------------------------------------------------------------
+bool WordLibrary::watch(const std::string &filename)
+{
+    stopWatching();
+
+    // Watch the directory rather than the file, a file replaced by
+    // rename would otherwise drop the watch.
+    std::string directory(".");
+    size_t slash(filename.find_last_of('/'));
+    if (slash == 0)
+        directory = "/";
+    else if (slash != std::string::npos)
+        directory = filename.substr(0, slash);
+
+    mFilename = filename;
+    mWatchError.clear();
+    mWatchName = (slash == std::string::npos) ? filename : filename.substr(slash + 1);
+
+    mNotifyFd = inotify_init1(IN_CLOEXEC);
+    mWakeFd = eventfd(0, EFD_CLOEXEC);
+    if ((mNotifyFd < 0) || (mWakeFd < 0) ||
+        (inotify_add_watch(mNotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0))
+    {
+        std::cerr << "Unable to watch \"" << filename << "\"" << std::endl;
+        stopWatching();
+        return false;
+    }
+
+    mThread = std::thread(&WordLibrary::watcher, this);
+    return true;
+}
+
+void WordLibrary::stopWatching()
+{
+    if (mThread.joinable())
+    {
+        uint64_t one(1);
+        if (write(mWakeFd, &one, sizeof(one)) < 0)
+        {}
+        mThread.join();
+    }
+
+    if (mNotifyFd >= 0)
+        close(mNotifyFd);
+    if (mWakeFd >= 0)
+        close(mWakeFd);
+    mNotifyFd = -1;
+    mWakeFd = -1;
+}
+
+//------------------------------------------------------------------------
+void WordLibrary::watcher()
+{
+    alignas(struct inotify_event) char buffer[sizeof(struct inotify_event) + NAME_MAX + 1];
+    bool pending(false);
+
+    while (true)
+    {
+        struct pollfd fds[2] = {
+            { mNotifyFd, POLLIN, 0 },
+            { mWakeFd, POLLIN, 0 }
+        };
+
+        int ready(poll(fds, 2, pending ? SETTLE_MS : -1));
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            mWatchError = "Stopped watching \"" + mFilename + "\": " + std::strerror(errno);
+            break;
+        }
+        if (fds[1].revents)
+            break;
+
+        if (!ready)
+        {   // quiet for SETTLE_MS since the last change
+            pending = false;
+            reload();
+            continue;
+        }
+
+        ssize_t length(read(mNotifyFd, buffer, sizeof(buffer)));
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const struct inotify_event *event(reinterpret_cast<const struct inotify_event *>(buffer + offset));
+            if (event->len && (mWatchName == event->name))
+                pending = true;
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+void WordLibrary::reload()
+{
+    FalloutWords::ptr_t words(std::make_shared<FalloutWords>(snapshot()->getTierWeighting()));
+
+    // A half written or emptied file keeps the current dictionary.
+    if (!words->loadWordList(mFilename, false) || !words->isPlayable())
+        return;
+
+    publish(words);
+}
@@ -0,0 +1,93 @@
+/**
+ */
+
+#ifndef FALLOUT_WORDLIBRARY_H
+#define FALLOUT_WORDLIBRARY_H
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include "gamedata.h"
+
+//========================================================================
+// Holds the current dictionary.  Readers take a snapshot, which pins
+// that version for as long as they hold it; a reload publishes a new
+// FalloutWords atomically and the old one is freed when its last
+// snapshot goes away.
+class WordLibrary
+{
+public:
+    typedef std::shared_ptr<WordLibrary>    ptr_t;
+
+    explicit WordLibrary(const FalloutWords::ptr_t &words);
+    ~WordLibrary();
+
+    FalloutWords::ptr_t     snapshot() const    { return std::atomic_load(&mWords); }
+    void                    publish(const FalloutWords::ptr_t &words);
+
+    unsigned                getGeneration() const { return mGeneration; }
+
+    // Load filename on a background thread.  As soon as the words read
+    // so far can make a board of difficulty (0 for any) they are
+    // published, and the complete dictionary replaces them when the file
+    // is done.  A reload from watch() in the meantime wins over both.
+    void                    startLoading(const std::string &filename, int difficulty);
+
+    /// Wait up to timeout for something playable to be published or the
+    /// load to end.  True if either happened.
+    bool                    waitPlayable(std::chrono::milliseconds timeout);
+
+    /// Wait for the load to end, true if the whole file was read and
+    /// was playable.
+    bool                    finishLoading();
+
+    /// Abandon the load and wait for the loading thread to stop.
+    void                    cancelLoading();
+
+    size_t                  getLoadedWords() const { return mLoadedWords; }
+
+    // Watch filename with inotify and reload it in the background
+    // whenever it is rewritten or replaced.
+    bool                    watch(const std::string &filename);
+    void                    stopWatching();
+
+    /// Why the watch gave up, if it did.  Only after stopWatching(), the
+    /// watcher can't write to a terminal the game owns.
+    const std::string &     getWatchError() const { return mWatchError; }
+
+private:
+    void                    loader(std::string filename, int difficulty);
+    void                    watcher();
+    void                    reload();
+
+    /// Publish only if nothing has been since generation, which is then
+    /// moved on to the new one.
+    bool                    publishOver(const FalloutWords::ptr_t &words, unsigned &generation);
+
+    FalloutWords::ptr_t     mWords;
+    std::atomic<unsigned>   mGeneration;
+    std::mutex              mPublishMutex;
+
+    std::string             mFilename;
+    std::string             mWatchName;
+    std::string             mWatchError;
+    int                     mNotifyFd;
+    int                     mWakeFd;
+    std::thread             mThread;
+
+    std::thread             mLoader;
+    std::mutex              mLoadMutex;
+    std::condition_variable mLoadChanged;
+    std::atomic<size_t>     mLoadedWords;
+    std::atomic<bool>       mLoadCancel;
+    bool                    mLoadPlayable;      // guarded by mLoadMutex
+    bool                    mLoadDone;          // guarded by mLoadMutex
+    bool                    mLoadSucceeded;     // guarded by mLoadMutex
+};
+
+#endif // !FALLOUT_WORDLIBRARY_H
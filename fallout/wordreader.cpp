@@ -0,0 +1,373 @@
+/**
+ */
+
+#include "wordreader.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+    const size_t INPUT_SIZE = 64 * 1024;
+
+    const unsigned char GZIP_MAGIC[] = { 0x1f, 0x8b };
+    const unsigned char ZSTD_MAGIC[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+    inline bool is_space(char c)
+    {
+        return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+    }
+}
+
+//========================================================================
+WordReader::WordReader():
+    mFd(-1),
+    mOwnFd(false),
+    mFormat(FORMAT_PLAIN),
+    mDecoder(nullptr),
+    mInput(INPUT_SIZE),
+    mInputPos(0),
+    mInputEnd(0),
+    mInputEof(false),
+    mFrameOpen(false),
+    mBuffers(),
+    mMutex(),
+    mChanged(),
+    mEnd(false),
+    mStop(false),
+    mError(false),
+    mThread(),
+    mCurrent(nullptr),
+    mCurrentIndex(0),
+    mCurrentPos(0)
+{
+    for (Buffer &buffer : mBuffers)
+    {
+        buffer.mData.resize(sBufferSize);
+    }
+}
+
+WordReader::~WordReader()
+{
+    if (mThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mChanged.notify_all();
+        mThread.join();
+    }
+
+    closeDecoder();
+    if (mOwnFd && (mFd >= 0))
+        close(mFd);
+}
+
+bool WordReader::open(const std::string &filename, bool verbose)
+{
+    if (filename == "-")
+    {
+        mFd = STDIN_FILENO;
+        mOwnFd = false;
+    }
+    else
+    {
+        mFd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        mOwnFd = true;
+    }
+
+    if (mFd < 0)
+    {
+        if (verbose)
+            std::cerr << "Unable to open \"" << filename << "\"" << std::endl;
+        return false;
+    }
+
+    // Sniff the format from whatever the first read returns, so a pipe
+    // works as well as a file.
+    while ((mInputEnd < sizeof(ZSTD_MAGIC)) && !mInputEof)
+    {
+        if (!readInput())
+            break;
+    }
+
+    if ((mInputEnd >= sizeof(GZIP_MAGIC)) && !memcmp(mInput.data(), GZIP_MAGIC, sizeof(GZIP_MAGIC)))
+    {
+        z_stream *stream(new z_stream());
+        if (inflateInit2(stream, 15 + 16) != Z_OK)
+        {
+            delete stream;
+            mError = true;
+            return false;
+        }
+        mDecoder = stream;
+        mFormat = FORMAT_GZIP;
+    }
+    else if ((mInputEnd >= sizeof(ZSTD_MAGIC)) && !memcmp(mInput.data(), ZSTD_MAGIC, sizeof(ZSTD_MAGIC)))
+    {
+#ifdef HAVE_ZSTD
+        mDecoder = ZSTD_createDStream();
+        mFormat = FORMAT_ZSTD;
+#else
+        if (verbose)
+            std::cerr << "\"" << filename << "\" is zstd compressed, built without zstd support" << std::endl;
+        mError = true;
+        return false;
+#endif
+    }
+
+    mThread = std::thread(&WordReader::producer, this);
+    return true;
+}
+
+//------------------------------------------------------------------------
+bool WordReader::next(std::string &word)
+{
+    word.clear();
+
+    while (true)
+    {
+        if (!mCurrent || (mCurrentPos >= mCurrent->mLength))
+        {
+            if (!nextBuffer())
+                return !word.empty();
+        }
+
+        const char *data(mCurrent->mData.data());
+        size_t length(mCurrent->mLength);
+        size_t pos(mCurrentPos);
+
+        if (word.empty())
+        {
+            while ((pos < length) && is_space(data[pos]))
+                ++pos;
+        }
+
+        size_t start(pos);
+        while ((pos < length) && !is_space(data[pos]))
+            ++pos;
+        word.append(data + start, pos - start);
+        mCurrentPos = pos;
+
+        // A word running into the end of the buffer continues in the
+        // next one.
+        if ((pos < length) && !word.empty())
+            return true;
+    }
+}
+
+bool WordReader::nextBuffer()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mCurrent)
+    {
+        mCurrent->mFull = false;
+        mCurrentIndex ^= 1;
+        mChanged.notify_all();
+    }
+
+    Buffer &buffer(mBuffers[mCurrentIndex]);
+    mChanged.wait(lock, [&]() { return buffer.mFull || mEnd; });
+
+    mCurrent = &buffer;
+    mCurrentPos = 0;
+    return buffer.mFull;
+}
+
+//------------------------------------------------------------------------
+void WordReader::producer()
+{
+    int index(0);
+
+    while (true)
+    {
+        Buffer &buffer(mBuffers[index]);
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mChanged.wait(lock, [&]() { return !buffer.mFull || mStop; });
+            if (mStop)
+                return;
+        }
+
+        // The buffer is ours until it is marked full again.
+        size_t length(fill(buffer.mData.data(), buffer.mData.size()));
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!length)
+        {
+            mEnd = true;
+            mChanged.notify_all();
+            return;
+        }
+
+        buffer.mLength = length;
+        buffer.mFull = true;
+        mChanged.notify_all();
+        index ^= 1;
+    }
+}
+
+size_t WordReader::fill(char *out, size_t capacity)
+{
+    if (mError)
+        return 0;
+
+    switch (mFormat)
+    {
+    case FORMAT_GZIP:
+        return fillGzip(out, capacity);
+    case FORMAT_ZSTD:
+        return fillZstd(out, capacity);
+    default:
+        return fillPlain(out, capacity);
+    }
+}
+
+bool WordReader::readInput()
+{
+    if (mInputPos == mInputEnd)
+    {
+        mInputPos = 0;
+        mInputEnd = 0;
+    }
+
+    ssize_t length;
+    do
+    {
+        length = read(mFd, mInput.data() + mInputEnd, mInput.size() - mInputEnd);
+    } while ((length < 0) && (errno == EINTR));
+
+    if (length < 0)
+    {
+        mError = true;
+        return false;
+    }
+    if (!length)
+    {
+        mInputEof = true;
+        return false;
+    }
+
+    mInputEnd += length;
+    return true;
+}
+
+size_t WordReader::fillPlain(char *out, size_t capacity)
+{
+    size_t produced(0);
+
+    while (produced < capacity)
+    {
+        if ((mInputPos == mInputEnd) && !readInput())
+            break;
+
+        size_t count(std::min(capacity - produced, mInputEnd - mInputPos));
+        memcpy(out + produced, mInput.data() + mInputPos, count);
+        mInputPos += count;
+        produced += count;
+    }
+
+    return produced;
+}
+
+size_t WordReader::fillGzip(char *out, size_t capacity)
+{
+    z_stream *stream(static_cast<z_stream *>(mDecoder));
+
+    stream->next_out = reinterpret_cast<Bytef *>(out);
+    stream->avail_out = static_cast<uInt>(capacity);
+
+    while (stream->avail_out)
+    {
+        if ((mInputPos == mInputEnd) && !readInput())
+        {
+            if (mFrameOpen)
+                mError = true;      // truncated
+            break;
+        }
+
+        stream->next_in = reinterpret_cast<Bytef *>(mInput.data() + mInputPos);
+        stream->avail_in = static_cast<uInt>(mInputEnd - mInputPos);
+        mFrameOpen = true;
+
+        int result(inflate(stream, Z_NO_FLUSH));
+        mInputPos = mInputEnd - stream->avail_in;
+
+        if (result == Z_STREAM_END)
+        {   // gzip files may hold several members back to back
+            mFrameOpen = false;
+            inflateReset(stream);
+        }
+        else if ((result != Z_OK) && (result != Z_BUF_ERROR))
+        {
+            mError = true;
+            break;
+        }
+    }
+
+    return mError ? 0 : (capacity - stream->avail_out);
+}
+
+size_t WordReader::fillZstd(char *out, size_t capacity)
+{
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *stream(static_cast<ZSTD_DStream *>(mDecoder));
+    ZSTD_outBuffer output = { out, capacity, 0 };
+
+    while (output.pos < output.size)
+    {
+        if ((mInputPos == mInputEnd) && !readInput())
+        {
+            if (mFrameOpen)
+                mError = true;      // truncated
+            break;
+        }
+
+        ZSTD_inBuffer input = { mInput.data() + mInputPos, mInputEnd - mInputPos, 0 };
+        size_t result(ZSTD_decompressStream(stream, &output, &input));
+        mInputPos += input.pos;
+
+        if (ZSTD_isError(result))
+        {
+            mError = true;
+            break;
+        }
+        mFrameOpen = (result != 0);
+    }
+
+    return mError ? 0 : output.pos;
+#else
+    (void)out;
+    (void)capacity;
+    mError = true;
+    return 0;
+#endif
+}
+
+void WordReader::closeDecoder()
+{
+    if (!mDecoder)
+        return;
+
+    if (mFormat == FORMAT_GZIP)
+    {
+        z_stream *stream(static_cast<z_stream *>(mDecoder));
+        inflateEnd(stream);
+        delete stream;
+    }
+#ifdef HAVE_ZSTD
+    else if (mFormat == FORMAT_ZSTD)
+    {
+        ZSTD_freeDStream(static_cast<ZSTD_DStream *>(mDecoder));
+    }
+#endif
+    mDecoder = nullptr;
+}
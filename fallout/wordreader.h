@@ -0,0 +1,87 @@
+/**
+ */
+
+#ifndef FALLOUT_WORDREADER_H
+#define FALLOUT_WORDREADER_H
+
+#include <array>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+//========================================================================
+// Reads whitespace separated words from a plain, gzip or (when built
+// with libzstd) zstd file, or from stdin for "-".  The format is
+// sniffed from the first bytes.  A producer thread decompresses into
+// one half of a fixed double buffer while the caller tokenizes the
+// other, so nothing is ever expanded to disk or held whole in memory.
+class WordReader
+{
+public:
+    enum Format
+    {
+        FORMAT_PLAIN,
+        FORMAT_GZIP,
+        FORMAT_ZSTD
+    };
+
+    WordReader();
+    ~WordReader();
+
+    bool                    open(const std::string &filename, bool verbose = true);
+
+    /// Next word, false at the end of input or on a read error.
+    bool                    next(std::string &word);
+
+    bool                    failed() const  { return mError; }
+    Format                  getFormat() const { return mFormat; }
+
+private:
+    static const size_t     sBufferSize = 256 * 1024;
+
+    struct Buffer
+    {
+        std::vector<char>   mData;
+        size_t              mLength = 0;
+        bool                mFull = false;
+    };
+
+    // Producer side
+    void                    producer();
+    size_t                  fill(char *out, size_t capacity);
+    size_t                  fillPlain(char *out, size_t capacity);
+    size_t                  fillGzip(char *out, size_t capacity);
+    size_t                  fillZstd(char *out, size_t capacity);
+    bool                    readInput();
+    void                    closeDecoder();
+
+    // Consumer side
+    bool                    nextBuffer();
+
+    int                     mFd;
+    bool                    mOwnFd;
+    Format                  mFormat;
+    void *                  mDecoder;
+
+    std::vector<char>       mInput;
+    size_t                  mInputPos;
+    size_t                  mInputEnd;
+    bool                    mInputEof;
+    bool                    mFrameOpen;
+
+    std::array<Buffer, 2>   mBuffers;
+    std::mutex              mMutex;
+    std::condition_variable mChanged;
+    bool                    mEnd;
+    bool                    mStop;
+    bool                    mError;
+    std::thread             mThread;
+
+    Buffer *                mCurrent;
+    int                     mCurrentIndex;
+    size_t                  mCurrentPos;
+};
+
+#endif // !FALLOUT_WORDREADER_H
@@ -0,0 +1,379 @@
+// loadtest.cpp : Runs many copies of a terminal program on local ptys and
+// reports what each one costs.
+//
+
+#include "ptyinstance.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <poll.h>
+
+namespace
+{
+    namespace bpo = boost::program_options;
+
+    typedef PtyInstance::clock_t    pty_clock_t;
+
+    const double STOP_GRACE_SECONDS(2.0);   // after SIGTERM, before SIGKILL
+
+    struct LoadOptions
+    {
+        std::vector<std::string>    mCommand;
+        int             mInstances;
+        double          mWarmup;
+        double          mDuration;
+        double          mRate;
+        std::string     mKeys;
+        int             mRows;
+        int             mCols;
+        std::string     mTerm;
+        unsigned        mSeed;
+        std::string     mCsvFile;
+    };
+
+    /// A weighted key for the synthetic stream.
+    struct KeyChoice
+    {
+        const char *    mBytes;
+        int             mWeight;
+    };
+
+    // Mostly cursor movement, some guesses, and 'y' so a finished board
+    // is always followed by another.  Nothing that quits.
+    const KeyChoice GAME_KEYS[] = {
+        { "\x1b[A", 10 },
+        { "\x1b[B", 10 },
+        { "\x1b[C", 25 },
+        { "\x1b[D", 10 },
+        { "\r",     10 },
+        { "y",      2 }
+    };
+
+    struct Instance
+    {
+        Instance():
+            mPty(),
+            mNextKey(),
+            mCpuAtStart(0.0),
+            mStopped(false)
+        {}
+
+        PtyInstance         mPty;
+        pty_clock_t::time_point mNextKey;
+        double              mCpuAtStart;    // when keys started
+        bool                mStopped;       // still running at the end
+    };
+
+    bool load_options(int argc, char **argv, LoadOptions &load)
+    {
+        bpo::options_description options("Allowed Options");
+        options.add_options()
+            ("help,H",
+                "Produce this help message")
+            ("instances,n", bpo::value<int>()->default_value(8),
+                "Copies of the command to run at once")
+            ("warmup",      bpo::value<double>()->default_value(2.0),
+                "Seconds to let them start before sending keys")
+            ("duration",    bpo::value<double>()->default_value(10.0),
+                "Seconds to send keys and measure")
+            ("rate",        bpo::value<double>()->default_value(5.0),
+                "Keys per second sent to each instance")
+            ("keys",        bpo::value<std::string>()->default_value("game"),
+                "Synthetic key stream\n"
+                    "\tgame = Random fallout moves and guesses\n"
+                    "\tnone = No keys, just watch the output")
+            ("rows",        bpo::value<int>()->default_value(24),
+                "Terminal rows")
+            ("cols",        bpo::value<int>()->default_value(80),
+                "Terminal columns")
+            ("term",        bpo::value<std::string>()->default_value("xterm"),
+                "TERM for the command")
+            ("seed",        bpo::value<unsigned>()->default_value(1),
+                "Seed for the key streams")
+            ("csv",         bpo::value<std::string>(),
+                "Also write one line per instance to this file")
+            ("command",     bpo::value<std::vector<std::string>>(),
+                "Command and arguments to run, after --");
+
+        bpo::positional_options_description positional;
+        positional.add("command", -1);
+
+        bpo::variables_map vm;
+        try
+        {
+            bpo::store(bpo::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+            bpo::notify(vm);
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << "Bad command line:" << std::endl << e.what() << std::endl;
+            std::cout << options << std::endl;
+            return false;
+        }
+
+        if (vm.count("help") || !vm.count("command"))
+        {
+            std::cout << argv[0] << " [options] -- COMMAND [ARGS...]" << std::endl <<
+                "Runs copies of COMMAND on local ptys, drives them with synthetic keys" << std::endl <<
+                "and reports CPU, memory, output and key latency per instance." << std::endl << std::endl <<
+                options << std::endl;
+            return false;
+        }
+
+        load.mCommand = vm["command"].as<std::vector<std::string>>();
+        load.mInstances = vm["instances"].as<int>();
+        load.mWarmup = vm["warmup"].as<double>();
+        load.mDuration = vm["duration"].as<double>();
+        load.mRate = vm["rate"].as<double>();
+        load.mKeys = vm["keys"].as<std::string>();
+        load.mRows = vm["rows"].as<int>();
+        load.mCols = vm["cols"].as<int>();
+        load.mTerm = vm["term"].as<std::string>();
+        load.mSeed = vm["seed"].as<unsigned>();
+        if (vm.count("csv"))
+            load.mCsvFile = vm["csv"].as<std::string>();
+
+        if ((load.mKeys != "game") && (load.mKeys != "none"))
+        {
+            std::cerr << "Unknown key stream \"" << load.mKeys << "\"" << std::endl;
+            return false;
+        }
+        if ((load.mInstances < 1) || (load.mDuration <= 0.0) || (load.mRate <= 0.0))
+        {
+            std::cerr << "--instances, --duration and --rate must be positive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    pty_clock_t::duration seconds(double value)
+    {
+        return std::chrono::duration_cast<pty_clock_t::duration>(std::chrono::duration<double>(value));
+    }
+
+    double percentile(std::vector<double> &values, double fraction)
+    {
+        if (values.empty())
+            return 0.0;
+
+        size_t index(std::min(values.size() - 1, size_t(fraction * values.size())));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    /// Wait for output from any running instance until deadline and read
+    /// it.  Returns the number still open.
+    int poll_until(std::vector<std::unique_ptr<Instance>> &instances, pty_clock_t::time_point deadline)
+    {
+        std::vector<pollfd> fds;
+        std::vector<Instance *> owners;
+        for (const std::unique_ptr<Instance> &instance : instances)
+        {
+            if (instance->mPty.getFd() < 0)
+                continue;
+            fds.push_back({ instance->mPty.getFd(), POLLIN, 0 });
+            owners.push_back(instance.get());
+        }
+
+        pty_clock_t::duration wait(std::max(pty_clock_t::duration::zero(), deadline - pty_clock_t::now()));
+        timespec timeout;
+        timeout.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(wait).count();
+        timeout.tv_nsec = (std::chrono::duration_cast<std::chrono::nanoseconds>(wait) -
+            std::chrono::seconds(timeout.tv_sec)).count();
+
+        if (ppoll(fds.data(), fds.size(), &timeout, nullptr) > 0)
+        {
+            pty_clock_t::time_point now(pty_clock_t::now());
+            for (size_t i = 0; i < fds.size(); ++i)
+            {
+                if (fds[i].revents)
+                    owners[i]->mPty.drain(now);
+            }
+        }
+
+        int open(0);
+        for (const std::unique_ptr<Instance> &instance : instances)
+        {
+            instance->mPty.reap(false);
+            if (instance->mPty.getFd() >= 0)
+                ++open;
+        }
+        return open;
+    }
+
+    void report(const LoadOptions &load, std::vector<std::unique_ptr<Instance>> &instances)
+    {
+        std::unique_ptr<std::ofstream> csv;
+        if (!load.mCsvFile.empty())
+        {
+            csv = std::make_unique<std::ofstream>(load.mCsvFile);
+            *csv << "instance,pid,cpu_percent,max_rss_kb,bytes,keys,unanswered,p50_ms,p99_ms,max_ms,status" << std::endl;
+        }
+
+        std::vector<double> all;
+        double total_cpu(0.0);
+        long total_rss(0);
+        long max_rss(0);
+        uint64_t total_bytes(0);
+        uint64_t total_keys(0);
+        uint64_t total_unanswered(0);
+        int failed(0);
+
+        std::cout << std::fixed << std::setprecision(2) <<
+            "   #      pid   cpu%  rss MB   bytes/s  keys  no-reply  p50 ms  p99 ms  max ms" << std::endl;
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            PtyInstance &pty(instances[i]->mPty);
+            std::vector<double> &latencies(pty.getLatencies());
+            double cpu(100.0 * (pty.getCpuSeconds() - instances[i]->mCpuAtStart) / load.mDuration);
+            double worst(latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end()));
+            double p50(percentile(latencies, 0.50));
+            double p99(percentile(latencies, 0.99));
+
+            // However a program goes when told to stop is fine, curses
+            // exits with 1 on SIGTERM.  Before that it must exit cleanly.
+            int status(pty.getStatus());
+            bool ok(instances[i]->mStopped ?
+                (!WIFSIGNALED(status) || (WTERMSIG(status) == SIGTERM) || (WTERMSIG(status) == SIGKILL)) :
+                (WIFEXITED(status) && !WEXITSTATUS(status)));
+            if (!ok)
+                ++failed;
+
+            std::cout <<
+                std::setw(4) << i << std::setw(9) << pty.getPid() << std::setw(7) << cpu <<
+                std::setw(8) << (pty.getMaxRssKb() / 1024.0) <<
+                std::setw(10) << (pty.getBytes() / (load.mWarmup + load.mDuration)) <<
+                std::setw(6) << pty.getKeys() << std::setw(10) << pty.getUnanswered() <<
+                std::setw(8) << p50 << std::setw(8) << p99 << std::setw(8) << worst <<
+                (ok ? "" : "  FAILED") << std::endl;
+            if (csv)
+            {
+                *csv << i << ',' << pty.getPid() << ',' << cpu << ',' << pty.getMaxRssKb() << ',' <<
+                    pty.getBytes() << ',' << pty.getKeys() << ',' << pty.getUnanswered() << ',' <<
+                    p50 << ',' << p99 << ',' << worst << ',' << status << std::endl;
+            }
+
+            all.insert(all.end(), latencies.begin(), latencies.end());
+            total_cpu += cpu;
+            total_rss += pty.getMaxRssKb();
+            max_rss = std::max(max_rss, pty.getMaxRssKb());
+            total_bytes += pty.getBytes();
+            total_keys += pty.getKeys();
+            total_unanswered += pty.getUnanswered();
+        }
+
+        double count(double(instances.size()));
+        double per_instance(total_cpu / count);
+        std::cout << std::endl <<
+            "Instances:        " << instances.size() << (failed ? " (" + std::to_string(failed) + " failed)" : "") << std::endl <<
+            "CPU total:        " << total_cpu << " % of one core" << std::endl <<
+            "CPU per instance: " << per_instance << " %" << std::endl <<
+            "Max RSS mean:     " << (total_rss / count / 1024.0) << " MB" << std::endl <<
+            "Max RSS worst:    " << (max_rss / 1024.0) << " MB" << std::endl <<
+            "Output:           " << (total_bytes / count / (load.mWarmup + load.mDuration)) << " bytes/s per instance" << std::endl <<
+            "Keys:             " << total_keys << " (" << total_unanswered << " unanswered)" << std::endl <<
+            "Latency p50:      " << percentile(all, 0.50) << " ms" << std::endl <<
+            "Latency p90:      " << percentile(all, 0.90) << " ms" << std::endl <<
+            "Latency p99:      " << percentile(all, 0.99) << " ms" << std::endl <<
+            "Latency max:      " << (all.empty() ? 0.0 : *std::max_element(all.begin(), all.end())) << " ms" << std::endl;
+        if (per_instance > 0.0)
+            std::cout << "Instances/core:   " << (100.0 / per_instance) << " at this load" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions load;
+    if (!load_options(argc, argv, load))
+        return -1;
+
+    // A program that dies early must not take the harness with it.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::unique_ptr<Instance>> instances;
+    for (int i = 0; i < load.mInstances; ++i)
+    {
+        instances.push_back(std::make_unique<Instance>());
+        if (!instances.back()->mPty.start(load.mCommand, load.mRows, load.mCols, load.mTerm))
+            return -1;
+    }
+
+    pty_clock_t::time_point started(pty_clock_t::now());
+    pty_clock_t::time_point keys_start(started + seconds(load.mWarmup));
+    pty_clock_t::time_point keys_end(keys_start + seconds(load.mDuration));
+
+    // Spread the instances' keys across the interval, so they do not all
+    // arrive at once.
+    std::mt19937 random(load.mSeed);
+    pty_clock_t::duration interval(seconds(1.0 / load.mRate));
+    for (int i = 0; i < load.mInstances; ++i)
+    {
+        instances[i]->mNextKey = keys_start + ((interval * i) / load.mInstances);
+    }
+
+    std::vector<int> weights;
+    for (const KeyChoice &choice : GAME_KEYS)
+    {
+        weights.push_back(choice.mWeight);
+    }
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+
+    poll_until(instances, keys_start);
+    for (const std::unique_ptr<Instance> &instance : instances)
+    {
+        instance->mCpuAtStart = instance->mPty.getCpuSeconds();
+    }
+
+    bool sending(load.mKeys != "none");
+    while (pty_clock_t::now() < keys_end)
+    {
+        pty_clock_t::time_point next(keys_end);
+        if (sending)
+        {
+            for (const std::unique_ptr<Instance> &instance : instances)
+            {
+                next = std::min(next, instance->mNextKey);
+            }
+        }
+
+        if (!poll_until(instances, next))
+            break;
+
+        pty_clock_t::time_point now(pty_clock_t::now());
+        for (const std::unique_ptr<Instance> &instance : instances)
+        {
+            if (!sending || (instance->mNextKey > now))
+                continue;
+
+            instance->mPty.sendKey(GAME_KEYS[pick(random)].mBytes, now);
+            instance->mNextKey += interval;
+        }
+    }
+
+    // CPU is measured over the key phase only, the final figures come
+    // from each program's resource usage once it has gone.
+    for (const std::unique_ptr<Instance> &instance : instances)
+    {
+        instance->mStopped = instance->mPty.isRunning();
+        instance->mPty.signal(SIGTERM);
+    }
+    pty_clock_t::time_point grace(pty_clock_t::now() + seconds(STOP_GRACE_SECONDS));
+    while ((pty_clock_t::now() < grace) && poll_until(instances, grace))
+    {
+    }
+    for (const std::unique_ptr<Instance> &instance : instances)
+    {
+        instance->mPty.signal(SIGKILL);
+        instance->mPty.reap(true);
+    }
+
+    report(load, instances);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ */
+
+#include "ptyinstance.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//========================================================================
+PtyInstance::PtyInstance():
+    mFd(-1),
+    mPid(-1),
+    mExited(false),
+    mStatus(0),
+    mBytes(0),
+    mKeys(0),
+    mUnanswered(0),
+    mPending(false),
+    mPendingSince(),
+    mLatencies(),
+    mCpuSeconds(0.0),
+    mMaxRssKb(0)
+{
+}
+
+PtyInstance::~PtyInstance()
+{
+    if (isRunning())
+    {
+        signal(SIGKILL);
+        reap(true);
+    }
+    closeFd();
+}
+
+bool PtyInstance::start(const std::vector<std::string> &command, int rows, int cols, const std::string &term)
+{
+    struct winsize size = {};
+    size.ws_row = static_cast<unsigned short>(rows);
+    size.ws_col = static_cast<unsigned short>(cols);
+
+    // Build argv before forking, the child only calls exec.
+    std::vector<char *> argv;
+    for (const std::string &arg : command)
+    {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    mPid = forkpty(&mFd, nullptr, nullptr, &size);
+    if (mPid < 0)
+    {
+        std::cerr << "Unable to create a pty" << std::endl;
+        return false;
+    }
+
+    if (mPid == 0)
+    {
+        setenv("TERM", term.c_str(), 1);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    fcntl(mFd, F_SETFL, fcntl(mFd, F_GETFL) | O_NONBLOCK);
+    fcntl(mFd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+void PtyInstance::sendKey(std::string_view key, clock_t::time_point now)
+{
+    if (mFd < 0)
+        return;
+
+    if (write(mFd, key.data(), key.size()) != ssize_t(key.size()))
+        return;
+
+    if (mPending)
+        ++mUnanswered;
+    ++mKeys;
+    mPending = true;
+    mPendingSince = now;
+}
+
+bool PtyInstance::drain(clock_t::time_point now)
+{
+    char buffer[16384];
+
+    while (mFd >= 0)
+    {
+        ssize_t length(read(mFd, buffer, sizeof(buffer)));
+        if (length > 0)
+        {
+            if (mPending)
+            {
+                mLatencies.push_back(std::chrono::duration<double, std::milli>(now - mPendingSince).count());
+                mPending = false;
+            }
+            mBytes += uint64_t(length);
+            continue;
+        }
+
+        if ((length < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+            return true;
+
+        // EIO once the last slave descriptor is gone.
+        closeFd();
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------
+bool PtyInstance::reap(bool block)
+{
+    if (mPid <= 0)
+        return false;
+    if (mExited)
+        return true;
+
+    struct rusage usage;
+    int status(0);
+    pid_t result;
+    do
+    {
+        result = wait4(mPid, &status, block ? 0 : WNOHANG, &usage);
+    } while ((result < 0) && (errno == EINTR));
+
+    if (result != mPid)
+        return false;
+
+    mExited = true;
+    mStatus = status;
+    mCpuSeconds = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+        ((usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+    mMaxRssKb = usage.ru_maxrss;
+    return true;
+}
+
+double PtyInstance::getCpuSeconds() const
+{
+    if (mExited || (mPid <= 0))
+        return mCpuSeconds;
+
+    std::ifstream file("/proc/" + std::to_string(mPid) + "/stat");
+    std::string line;
+    if (!std::getline(file, line))
+        return 0.0;
+
+    // utime and stime are fields 14 and 15, counting from the pid.  The
+    // command name can hold spaces, so count from after it.
+    size_t name_end(line.rfind(')'));
+    if (name_end == std::string::npos)
+        return 0.0;
+
+    std::istringstream fields(line.substr(name_end + 2));
+    std::string skip;
+    for (int i = 3; i < 14; ++i)
+    {
+        fields >> skip;
+    }
+    unsigned long utime(0);
+    unsigned long stime(0);
+    fields >> utime >> stime;
+    return double(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+void PtyInstance::signal(int sig)
+{
+    if (isRunning())
+        kill(mPid, sig);
+}
+
+void PtyInstance::closeFd()
+{
+    if (mFd >= 0)
+        close(mFd);
+    mFd = -1;
+    mPending = false;
+}
@@ -0,0 +1,80 @@
+/**
+ */
+
+#ifndef LOADTEST_PTYINSTANCE_H
+#define LOADTEST_PTYINSTANCE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+//========================================================================
+// One program running on its own pseudo-terminal.  Keys are written to
+// the master side and everything the program draws is read back and
+// counted.  The time from a key to the next output is recorded as that
+// key's latency.  A key that gets no output before the next one is sent
+// is counted as unanswered instead.
+class PtyInstance
+{
+public:
+    typedef std::chrono::steady_clock   clock_t;
+
+    PtyInstance();
+    ~PtyInstance();
+
+    PtyInstance(const PtyInstance &) = delete;
+    PtyInstance &operator=(const PtyInstance &) = delete;
+
+    /// Fork command onto a new pty of rows x cols with TERM set to term.
+    bool                start(const std::vector<std::string> &command, int rows, int cols,
+                            const std::string &term);
+
+    int                 getFd() const           { return mFd; }
+    pid_t               getPid() const          { return mPid; }
+    bool                isRunning() const       { return mPid > 0 && !mExited; }
+
+    void                sendKey(std::string_view key, clock_t::time_point now);
+
+    /// Read whatever output is waiting.  Returns false once the pty is
+    /// closed, the program has exited.
+    bool                drain(clock_t::time_point now);
+
+    /// Collect the exit status and resource usage if the program has
+    /// exited, waiting for it if block is set.
+    bool                reap(bool block);
+    void                signal(int sig);
+
+    uint64_t            getBytes() const        { return mBytes; }
+    uint64_t            getKeys() const         { return mKeys; }
+    uint64_t            getUnanswered() const   { return mUnanswered; }
+    std::vector<double> &getLatencies()         { return mLatencies; }   // milliseconds
+
+    /// CPU time so far, from /proc while it runs and from its resource
+    /// usage once reaped.
+    double              getCpuSeconds() const;
+    long                getMaxRssKb() const     { return mMaxRssKb; }
+    int                 getStatus() const       { return mStatus; }
+
+private:
+    void                closeFd();
+
+    int                 mFd;
+    pid_t               mPid;
+    bool                mExited;
+    int                 mStatus;
+
+    uint64_t            mBytes;
+    uint64_t            mKeys;
+    uint64_t            mUnanswered;
+    bool                mPending;
+    clock_t::time_point mPendingSince;
+    std::vector<double> mLatencies;
+
+    double              mCpuSeconds;
+    long                mMaxRssKb;
+};
+
+#endif // !LOADTEST_PTYINSTANCE_H
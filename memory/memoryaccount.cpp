@@ -0,0 +1,164 @@
+/**
+ */
+
+#include "memoryaccount.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+//========================================================================
+namespace
+{
+    // Totals of the accounts of one name that are gone, so boards that
+    // have been destroyed still show in the report.
+    struct Retired
+    {
+        const char *    mName;
+        int             mMade;
+        size_t          mPeak;
+        uint64_t        mAllocations;
+        uint64_t        mRefused;
+    };
+
+    std::mutex gMutex;
+    std::vector<MemoryAccount *> gAccounts;
+    std::vector<Retired> gRetired;
+
+    Retired &find_retired(const char *name)
+    {
+        for (Retired &retired : gRetired)
+        {
+            if (!std::strcmp(retired.mName, name))
+                return retired;
+        }
+        gRetired.push_back({ name, 0, 0, 0, 0 });
+        return gRetired.back();
+    }
+}
+
+//========================================================================
+MemoryAccount::MemoryAccount(const char *name, std::pmr::memory_resource *upstream):
+    mName(name),
+    mUpstream(upstream),
+    mBudget(0),
+    mLive(0),
+    mPeak(0),
+    mAllocations(0),
+    mRefused(0)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++find_retired(mName).mMade;
+    gAccounts.push_back(this);
+}
+
+MemoryAccount::~MemoryAccount()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    Retired &retired(find_retired(mName));
+    retired.mPeak = std::max(retired.mPeak, getPeak());
+    retired.mAllocations += getAllocations();
+    retired.mRefused += getRefused();
+    gAccounts.erase(std::find(gAccounts.begin(), gAccounts.end(), this));
+}
+
+void MemoryAccount::addFixed(size_t bytes)
+{
+    charge(bytes);
+}
+
+//------------------------------------------------------------------------
+void *MemoryAccount::do_allocate(size_t bytes, size_t alignment)
+{
+    // Reserve the bytes before checking, so threads sharing the account
+    // cannot each see room for themselves and overshoot together.
+    size_t live(mLive.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    size_t budget(getBudget());
+    if (budget && (live > budget))
+    {
+        mLive.fetch_sub(bytes, std::memory_order_relaxed);
+        mRefused.fetch_add(1, std::memory_order_relaxed);
+        throw std::bad_alloc();
+    }
+
+    void *block(nullptr);
+    try
+    {
+        block = mUpstream->allocate(bytes, alignment);
+    }
+    catch (...)
+    {
+        mLive.fetch_sub(bytes, std::memory_order_relaxed);
+        throw;
+    }
+    mAllocations.fetch_add(1, std::memory_order_relaxed);
+    raisePeak(live);
+    return block;
+}
+
+void MemoryAccount::do_deallocate(void *block, size_t bytes, size_t alignment)
+{
+    mUpstream->deallocate(block, bytes, alignment);
+    mLive.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool MemoryAccount::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void MemoryAccount::charge(size_t bytes)
+{
+    raisePeak(mLive.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryAccount::raisePeak(size_t live)
+{
+    size_t peak(mPeak.load(std::memory_order_relaxed));
+    while ((live > peak) && !mPeak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+}
+
+//------------------------------------------------------------------------
+void MemoryAccount::report(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+
+    out << "Memory          accounts    live KB    peak KB  allocations  refused  budget KB" << std::endl;
+    for (const Retired &retired : gRetired)
+    {
+        size_t live(0);
+        size_t peak(retired.mPeak);
+        uint64_t allocations(retired.mAllocations);
+        uint64_t refused(retired.mRefused);
+        size_t budget(0);
+
+        for (const MemoryAccount *account : gAccounts)
+        {
+            if (std::strcmp(account->getName(), retired.mName))
+                continue;
+            live += account->getLive();
+            peak = std::max(peak, account->getPeak());
+            allocations += account->getAllocations();
+            refused += account->getRefused();
+            budget = std::max(budget, account->getBudget());
+        }
+
+        // The peak is of the largest single account, per board and so on.
+        out << std::left << std::setw(16) << retired.mName << std::right << std::fixed << std::setprecision(1) <<
+            std::setw(8) << retired.mMade <<
+            std::setw(11) << (live / 1024.0) <<
+            std::setw(11) << (peak / 1024.0) <<
+            std::setw(13) << allocations <<
+            std::setw(9) << refused;
+        if (budget)
+            out << std::setw(11) << (budget / 1024.0);
+        else
+            out << std::setw(11) << "-";
+        out << std::endl;
+    }
+}
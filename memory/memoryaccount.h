@@ -0,0 +1,68 @@
+/**
+ */
+
+#ifndef MEMORY_MEMORYACCOUNT_H
+#define MEMORY_MEMORYACCOUNT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory_resource>
+
+//========================================================================
+// A memory resource that charges what a subsystem allocates to a named
+// account, then passes the request upstream.  It keeps live bytes, the
+// peak and the allocation count, and can refuse to go over a budget by
+// throwing std::bad_alloc, as any memory_resource does when it is out of
+// memory.  Counters are atomics, an account can be shared by threads.
+//
+// Every account is listed for report() while it exists.  Accounts with
+// the same name, one per game board say, are reported together.
+class MemoryAccount : public std::pmr::memory_resource
+{
+public:
+    explicit MemoryAccount(const char *name,
+        std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    ~MemoryAccount() override;
+
+    MemoryAccount(const MemoryAccount &) = delete;
+    MemoryAccount &operator=(const MemoryAccount &) = delete;
+
+    const char *            getName() const         { return mName; }
+
+    /// 0 for no limit.
+    void                    setBudget(size_t bytes) { mBudget.store(bytes, std::memory_order_relaxed); }
+    size_t                  getBudget() const       { return mBudget.load(std::memory_order_relaxed); }
+
+    size_t                  getLive() const         { return mLive.load(std::memory_order_relaxed); }
+    size_t                  getPeak() const         { return mPeak.load(std::memory_order_relaxed); }
+    uint64_t                getAllocations() const  { return mAllocations.load(std::memory_order_relaxed); }
+    uint64_t                getRefused() const      { return mRefused.load(std::memory_order_relaxed); }
+
+    /// Charge memory the subsystem holds without allocating it here, an
+    /// object's own footprint for instance.  Never refused.
+    void                    addFixed(size_t bytes);
+
+    /// One line per account name, in the order they were first made.
+    static void             report(std::ostream &out);
+
+protected:
+    void *                  do_allocate(size_t bytes, size_t alignment) override;
+    void                    do_deallocate(void *block, size_t bytes, size_t alignment) override;
+    bool                    do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    void                    charge(size_t bytes);
+    void                    raisePeak(size_t live);
+
+    const char *            mName;
+    std::pmr::memory_resource * mUpstream;
+    std::atomic<size_t>     mBudget;
+    std::atomic<size_t>     mLive;
+    std::atomic<size_t>     mPeak;
+    std::atomic<uint64_t>   mAllocations;
+    std::atomic<uint64_t>   mRefused;
+};
+
+#endif // !MEMORY_MEMORYACCOUNT_H
@@ -1,24 +1,182 @@
 
 #include "lockoutwindow.h"
-#include <iostream>
-#include <fstream>
-#include <boost/algorithm/string.hpp>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
 
-#include <thread>
-#include <chrono>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
 //========================================================================
 namespace
 {
-    bool kbhit()
+    const long long MS_PER_SECOND(1000);
+    const long long NS_PER_MS(1000000);
+
+    long long monotonic_ms()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (now.tv_sec * MS_PER_SECOND) + (now.tv_nsec / NS_PER_MS);
+    }
+
+    struct timespec to_timespec(long long ms)
+    {
+        struct timespec value;
+        value.tv_sec = ms / MS_PER_SECOND;
+        value.tv_nsec = (ms % MS_PER_SECOND) * NS_PER_MS;
+        return value;
+    }
+}
+
+//========================================================================
+const char * LockoutWindow::sLabel("TERMINAL LOCKED");
+
+//========================================================================
+LockoutWindow::LockoutWindow(WINDOW *pwin, const OptionsData::ptr_t &opts):
+    mWindow(pwin),
+    mOpts(opts),
+    mTimerFd(-1),
+    mRow(0),
+    mColumn(0),
+    mShowHours(false),
+    mShown(),
+    mError()
+{
+    mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (mTimerFd < 0)
+        fail("Unable to create lockout timer");
+}
+
+LockoutWindow::~LockoutWindow()
+{
+    if (mTimerFd >= 0)
+        close(mTimerFd);
+}
+
+//-------------------------------------------------------------------------
+bool LockoutWindow::lockout()
+{
+    if (mTimerFd < 0)
+        return false;
+
+    long long duration_ms(static_cast<long long>(mOpts->mTimeoutSeconds * MS_PER_SECOND));
+    long long deadline(monotonic_ms() + duration_ms);
+
+    mShowHours = (duration_ms >= (3600 * MS_PER_SECOND));
+    drawLabel();
+
+    struct pollfd fds[2];
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    fds[1].fd = mTimerFd;
+    fds[1].events = POLLIN;
+
+    while (true)
     {
-        int ch = getch();
+        long long remaining(deadline - monotonic_ms());
+        if (remaining <= 0)
+            break;
+
+        drawCountdown(remaining);
+
+        // Sleep until the displayed second changes.  The last step lands
+        // exactly on the deadline.
+        long long next_tick(deadline - (((remaining - 1) / MS_PER_SECOND) * MS_PER_SECOND));
+        struct itimerspec timer;
+        std::memset(&timer, 0, sizeof(timer));
+        timer.it_value = to_timespec(next_tick);
+        if (timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &timer, nullptr) < 0)
+            return fail("Unable to set lockout timer");
 
-        if (ch != ERR) 
+        if (poll(fds, 2, -1) < 0)
         {
-            ungetch(ch);
-            return true;
+            if (errno == EINTR)
+                continue;
+            return fail("Lockout wait failed");
+        }
+
+        // A hung up or closed stdin stays readable forever, from then on
+        // only the timer is waited on.
+        if ((fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) ||
+            ((fds[0].revents & POLLIN) && !drainInput()))
+            fds[0].fd = -1;
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t expirations(0);
+            if (read(mTimerFd, &expirations, sizeof(expirations)) < 0)
+            {
+                if (errno != EAGAIN)
+                    return fail("Unable to read lockout timer");
+            }
         }
-        return false;
     }
+
+    drawCountdown(0);
+    return true;
+}
+
+//-------------------------------------------------------------------------
+void LockoutWindow::drawLabel()
+{
+    int window_x(0);
+    int window_y(0);
+    getmaxyx(mWindow, window_y, window_x);
+
+    int label_length((int)std::strlen(sLabel));
+    int countdown_length(mShowHours ? 8 : 5);
+
+    mRow = std::max(0, window_y - 1);
+    mColumn = std::max(0, (window_x - countdown_length) / 2);
+    mShown.assign(countdown_length, ' ');
+
+    mvwaddstr(mWindow, std::max(0, mRow - 1), std::max(0, (window_x - label_length) / 2), sLabel);
+    wrefresh(mWindow);
+}
+
+void LockoutWindow::drawCountdown(long long remaining_ms)
+{
+    long long seconds((remaining_ms + MS_PER_SECOND - 1) / MS_PER_SECOND);
+
+    // Sized for any long long, though the hours never get that far.
+    char text[64];
+    if (mShowHours)
+        std::snprintf(text, sizeof(text), "%02lld:%02lld:%02lld",
+            seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    else
+        std::snprintf(text, sizeof(text), "%02lld:%02lld", seconds / 60, seconds % 60);
+
+    bool changed(false);
+    for (size_t i = 0; (i < mShown.size()) && text[i]; ++i)
+    {
+        if (mShown[i] != text[i])
+        {
+            mvwaddch(mWindow, mRow, mColumn + (int)i, text[i]);
+            mShown[i] = text[i];
+            changed = true;
+        }
+    }
+
+    if (changed)
+        wrefresh(mWindow);
+}
+
+/// False if stdin was readable but had no keys, which is end of file.
+bool LockoutWindow::drainInput()
+{
+    bool any(false);
+    while (wgetch(mWindow) != ERR)
+    {
+        any = true;
+    }
+    return any;
+}
+
+bool LockoutWindow::fail(const char *what)
+{
+    mError = std::string(what) + ": " + std::strerror(errno);
+    return false;
 }
@@ -1,11 +1,40 @@
-
 #ifndef LOCKOUTWINDOW_H
 #define LOCKOUTWINDOW_H
 
 #include "screensave.h"
 
+#include <string>
+
 class LockoutWindow
 {
+public:
+                    LockoutWindow(WINDOW *pwin, const OptionsData::ptr_t &opts);
+                    ~LockoutWindow();
+
+    // Hold the terminal for mTimeoutSeconds, returning when the timeout
+    // expires.  Keyboard input is swallowed while locked.  On failure
+    // getError() says why; it is kept for after curses has shut down.
+    bool            lockout();
+
+    const std::string & getError() const { return mError; }
+
+private:
+    void            drawLabel();
+    void            drawCountdown(long long remaining_ms);
+    bool            drainInput();
+    bool            fail(const char *what);
+
+    WINDOW *            mWindow;
+    OptionsData::ptr_t  mOpts;
+    int                 mTimerFd;
+
+    int                 mRow;
+    int                 mColumn;
+    bool                mShowHours;
+    std::string         mShown;
+    std::string         mError;
+
+    static const char * sLabel;
 };
 
 #endif // !LOCKOUTWINDOW_H
@@ -3,6 +3,9 @@
 
 #include "screensave.h"
 #include "textscreen.h"
+#include "lockoutwindow.h"
+#include "tracer.h"
+#include "memoryaccount.h"
 
 namespace
 {
@@ -46,7 +49,18 @@ namespace
                 ("wait-for-key",
                     "Wait for key press when done.")
                 ("lockout-time", bpo::value<int>()->default_value(0),
-                    "Number of seconds to lock terminal");
+                    "Number of seconds to lock terminal")
+                ("max-inflight", bpo::value<int>()->default_value(0),
+                    "Maximum number of columns falling at once\n"
+                        "\t0 = Default (5)")
+                ("threads", bpo::value<int>()->default_value(0),
+                    "Worker threads used to update falling columns\n"
+                        "\t0 = One per CPU")
+                ("trace", bpo::value<std::string>(),
+                    "Write timing spans for every frame as Chrome trace JSON, for Perfetto "
+                    "(needs a build with FALLOUT_TRACING)")
+                ("memory-stats",
+                    "Print the live and peak memory of the columns on exit");
         }
 
         OptionsData::ptr_t load(int argc, char **argv)
@@ -83,6 +97,12 @@ namespace
             else
                 opts->mTimeoutSeconds = 0.f;
 
+            opts->mMaxInflight = vm["max-inflight"].as<int>();
+            opts->mThreads = vm["threads"].as<int>();
+            if (vm.count("trace"))
+                opts->mTraceFile = vm["trace"].as<std::string>();
+            opts->mMemoryStats = (vm.count("memory-stats") != 0);
+
             return opts;
         }
 
@@ -111,6 +131,12 @@ int main(int argc, char **argv)
             return -1;
     }
 
+    if (!opts->mTraceFile.empty() && !Tracer::enable(opts->mTraceFile))
+    {
+        std::cerr << "--trace needs a build with -DFALLOUT_TRACING=ON" << std::endl;
+        return -1;
+    }
+
     std::srand(static_cast<unsigned int>(time(nullptr)));
     initialize_curses();
 
@@ -120,13 +146,23 @@ int main(int argc, char **argv)
 
     text.play(gWindow);
 
+    std::string lockout_error;
     if (opts->mWaitForKey)
         getchar();
     else if (opts->mTimeoutSeconds >= 1.0f)
     {
+        LockoutWindow lockout(gWindow, opts);
+
+        if (!lockout.lockout())
+            lockout_error = lockout.getError();
     }
 
     shutdown_curses();
+    Tracer::write();
+    if (!lockout_error.empty())
+        std::cerr << lockout_error << std::endl;
+    if (opts->mMemoryStats)
+        MemoryAccount::report(std::cout);
 
-    return 0;
+    return lockout_error.empty() ? 0 : -1;
 }
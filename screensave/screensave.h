@@ -16,6 +16,10 @@ struct OptionsData
     std::string   mTextFile;
     bool          mWaitForKey;
     float         mTimeoutSeconds;
+    int           mMaxInflight;
+    int           mThreads;
+    std::string   mTraceFile;
+    bool          mMemoryStats;
 };
 
 #endif // !SCREENSAVE_H
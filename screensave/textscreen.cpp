@@ -1,11 +1,13 @@
 
 #include "textscreen.h"
+#include "tracer.h"
 #include <iostream>
 #include <fstream>
 #include <boost/algorithm/string.hpp>
 
 #include <thread>
 #include <chrono>
+#include <cstring>
 
 //========================================================================
 namespace
@@ -26,11 +28,21 @@ namespace
 //========================================================================
 const int TextScreen::sSpacing(5);
 const int TextScreen::sMaxInflight(5);
+const int TextScreen::sParallelThreshold(64);
 
 //========================================================================
 TextScreen::TextScreen(const OptionsData::ptr_t &opts):
-    mOpts(opts)
-{}
+    mMemory("columns"),
+    mColumns(&mMemory),
+    mOpts(opts),
+    mMaxColumn(0)
+{
+    int threads(mOpts->mThreads);
+    if (threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    mWorkers.reset(new WorkerPool(threads));
+}
 
 //-------------------------------------------------------------------------
 bool TextScreen::loadScreenText(const std::string &filepath)
@@ -88,7 +100,8 @@ void TextScreen::buildColumns(const text_vect_t &columns)
     {
         if (columns[col].size() > mMaxColumn)
             mMaxColumn = columns[col].size();
-        ColumnDef::ptr_t columndef(std::make_shared<ColumnDef>(col, columns[col]));
+        ColumnDef::ptr_t columndef(std::allocate_shared<ColumnDef>(
+            std::pmr::polymorphic_allocator<ColumnDef>(&mMemory), col, columns[col], &mMemory));
         mColumns[col] = columndef;
     }
 }
@@ -113,8 +126,8 @@ namespace
 
 void TextScreen::play(WINDOW *pwin)
 {
-    column_map_t remaining(mColumns);
-    column_map_t inflight;
+    column_map_t remaining(mColumns, &mMemory);
+    column_map_t inflight(&mMemory);
     int spacing_count(0);
 
     int window_x(0);
@@ -124,31 +137,48 @@ void TextScreen::play(WINDOW *pwin)
     int offset_x((window_x - mColumns.size()) / 2);
     int offset_y((window_y - mMaxColumn) / 2);
 
+    mFrame.resize(window_x, window_y);
+    mShown.resize(window_x, window_y);
+
+    size_t max_inflight(sMaxInflight);
+    if (mOpts->mMaxInflight > 0)
+        max_inflight = mOpts->mMaxInflight;
+
+    // Launch columns in proportion to the inflight limit so that raising
+    // it actually fills the screen rather than trickling in one column
+    // every sSpacing frames.
+    size_t launch_count(std::max<size_t>(1, max_inflight / sMaxInflight));
+
     while (!remaining.empty() || !inflight.empty())
     {
+        TRACE_SPAN("frame");
         --spacing_count;
-        if ((inflight.size() < sMaxInflight) && (spacing_count < 0))
+        if ((inflight.size() < max_inflight) && (spacing_count < 0))
         {
             spacing_count = sSpacing;
-            column_map_t::iterator it1 = select_random_column(remaining);
-            if (it1 != remaining.end())
+            size_t launched(0);
+            while ((launched < launch_count) && (inflight.size() < max_inflight))
             {
+                column_map_t::iterator it1 = select_random_column(remaining);
+                if (it1 == remaining.end())
+                    break;
+
                 if (!(*it1).second->isDone())
                 {
                     inflight[(*it1).first] = (*it1).second;
-                }
-                else
-                {
-                    spacing_count = 0;
+                    ++launched;
                 }
                 remaining.erase(it1);
             }
         }
 
+        processInflight(inflight, offset_x, offset_y);
+
+        size_t index(0);
         column_map_t::iterator it2 = inflight.begin(); 
         while(it2 != inflight.end())
         {
-            if ((*it2).second->process(pwin, offset_x, offset_y))
+            if (mResults[index++])
             {
                 ++it2;
             }
@@ -161,7 +191,15 @@ void TextScreen::play(WINDOW *pwin)
                 inflight.erase(it2++);
             }
         }
-        wrefresh(pwin);
+
+        {
+            TRACE_SPAN("emitChanges");
+            mFrame.emitChanges(pwin, mShown);
+        }
+        {
+            TRACE_SPAN("wrefresh");
+            wrefresh(pwin);
+        }
         //std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
 #if 0
@@ -171,16 +209,73 @@ void TextScreen::play(WINDOW *pwin)
     }
 }
 
+void TextScreen::processInflight(const column_map_t &inflight, int offset_x, int offset_y)
+{
+    // mActive is in column order, so splitting it evenly hands each
+    // worker a contiguous band of screen columns.
+    mActive.clear();
+    for (const auto &it : inflight)
+    {
+        mActive.push_back(it.second.get());
+    }
+    // char rather than bool, workers write neighbouring entries.
+    mResults.resize(mActive.size());
+
+    int slices(std::max<int>(1, (int)mActive.size() / sParallelThreshold));
+    slices = std::min(slices, mWorkers->getSize());
+
+    TRACE_SPAN("processInflight");
+    mWorkers->run(slices, [this, slices, offset_x, offset_y](int slice)
+    {
+        TRACE_SPAN("processSlice");
+        size_t begin((mActive.size() * slice) / slices);
+        size_t end((mActive.size() * (slice + 1)) / slices);
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            mResults[i] = mActive[i]->process(mFrame, offset_x, offset_y);
+        }
+    });
+}
+
+//========================================================================
+void TextScreen::FrameBuffer::resize(int width, int height)
+{
+    mWidth = std::max(0, width);
+    mHeight = std::max(0, height);
+    mCells.assign(mWidth * mHeight, ' ');
+}
+
+void TextScreen::FrameBuffer::emitChanges(WINDOW *pwin, FrameBuffer &shown) const
+{
+    for (int x = 0; x < mWidth; ++x)
+    {
+        const char *column(&mCells[x * mHeight]);
+        char *shown_column(&shown.mCells[x * mHeight]);
+
+        if (std::memcmp(column, shown_column, mHeight) == 0)
+            continue;
+
+        for (int y = 0; y < mHeight; ++y)
+        {
+            if (column[y] != shown_column[y])
+            {
+                mvwaddch(pwin, y, x, column[y]);
+                shown_column[y] = column[y];
+            }
+        }
+    }
+}
+
 //========================================================================
-bool TextScreen::ColumnDef::process(WINDOW *pwin, int offset_x, int offset_y)
+bool TextScreen::ColumnDef::process(FrameBuffer &frame, int offset_x, int offset_y)
 {
     if (mCurrentRow)
     {
-        mvwaddch(pwin, (mCurrentRow - 1) + offset_y, mColumnNumber + offset_x, ' ');
-        //std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        frame.setCell(mColumnNumber + offset_x, (mCurrentRow - 1) + offset_y, ' ');
     }
 
-    mvwaddch(pwin, mCurrentRow + offset_y, (int)(mColumnNumber + offset_x), mColumnText[mTargetRow]);
+    frame.setCell(mColumnNumber + offset_x, mCurrentRow + offset_y, mColumnText[mTargetRow]);
     
     ++mCurrentRow;
     if (mCurrentRow < mTargetRow)
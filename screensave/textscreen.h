@@ -3,6 +3,12 @@
 #define TEXTSCREEN_H
 
 #include "screensave.h"
+#include "workerpool.h"
+#include "memoryaccount.h"
+
+#include <map>
+#include <memory_resource>
+#include <vector>
 
 class TextScreen
 {
@@ -16,39 +22,76 @@ public:
     void            play(WINDOW *pwin);
 private:
     typedef std::vector<std::string>    text_vect_t;
+
+    // Column-major cell grid for one frame.  Every ColumnDef only ever
+    // touches its own screen column, so a contiguous run of columns is a
+    // contiguous region of mCells that one worker can own.
+    class FrameBuffer
+    {
+    public:
+        FrameBuffer():
+            mWidth(0),
+            mHeight(0),
+            mCells()
+        {}
+
+        void        resize(int width, int height);
+        void        setCell(int x, int y, char ch)
+        {
+            if ((x >= 0) && (x < mWidth) && (y >= 0) && (y < mHeight))
+                mCells[(x * mHeight) + y] = ch;
+        }
+
+        void        emitChanges(WINDOW *pwin, FrameBuffer &shown) const;
+
+    private:
+        int                 mWidth;
+        int                 mHeight;
+        std::vector<char>   mCells;
+    };
+
     class ColumnDef
     {
     public:
         typedef std::shared_ptr<ColumnDef>  ptr_t;
 
-        ColumnDef(int column_number, const std::string &column_text):
+        ColumnDef(int column_number, const std::string &column_text, std::pmr::memory_resource *memory):
             mColumnNumber(column_number),
-            mColumnText(column_text),
+            mColumnText(column_text.data(), column_text.size(), memory),
             mTargetRow(0),
             mCurrentRow(0)
         {
             mTargetRow = (int)mColumnText.size() - 1;
         }
 
-        bool        process(WINDOW *pwin, int offset_x, int offset_y);
+        bool        process(FrameBuffer &frame, int offset_x, int offset_y);
         bool        isDone() const;
         void        reset();
     private:
         int         mColumnNumber;
-        std::string mColumnText;
+        std::pmr::string mColumnText;
         int         mTargetRow;
         int         mCurrentRow;
     };
 
-    typedef std::map<int, ColumnDef::ptr_t> column_map_t;
+    typedef std::pmr::map<int, ColumnDef::ptr_t> column_map_t;
 
     void                buildColumns(const text_vect_t &columns);
+    void                processInflight(const column_map_t &inflight, int offset_x, int offset_y);
 
+    MemoryAccount       mMemory;    // the columns, their text and the maps of them
     column_map_t        mColumns;
     OptionsData::ptr_t  mOpts;
     int                 mMaxColumn;
 
+    FrameBuffer         mFrame;
+    FrameBuffer         mShown;
+    std::unique_ptr<WorkerPool> mWorkers;
+    std::vector<ColumnDef *>    mActive;
+    std::vector<char>           mResults;
+
     static const int    sSpacing;
+    static const int    sParallelThreshold;
     static const int    sMaxInflight;
 };
 
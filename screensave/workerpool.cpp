@@ -0,0 +1,89 @@
+
+#include "workerpool.h"
+#include <algorithm>
+
+//========================================================================
+WorkerPool::WorkerPool(int size):
+    mThreads(),
+    mTask(nullptr),
+    mSlices(0),
+    mPending(0),
+    mGeneration(0),
+    mShutdown(false)
+{
+    for (int slice = 1; slice < size; ++slice)
+    {
+        mThreads.emplace_back(&WorkerPool::worker, this, slice);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mStart.notify_all();
+
+    for (std::thread &thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+//-------------------------------------------------------------------------
+void WorkerPool::run(int slices, const task_t &task)
+{
+    slices = std::max(1, std::min(slices, getSize()));
+
+    if (slices > 1)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mSlices = slices;
+        mPending = slices - 1;
+        ++mGeneration;
+    }
+
+    if (slices > 1)
+        mStart.notify_all();
+
+    task(0);
+
+    if (slices > 1)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this]() { return (mPending == 0); });
+        mTask = nullptr;
+    }
+}
+
+void WorkerPool::worker(int slice)
+{
+    unsigned seen(0);
+
+    while (true)
+    {
+        const task_t *task(nullptr);
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStart.wait(lock, [this, seen]() { return mShutdown || (mGeneration != seen); });
+            if (mShutdown)
+                return;
+            seen = mGeneration;
+            if (slice < mSlices)
+                task = mTask;
+        }
+
+        if (!task)
+            continue;
+
+        (*task)(slice);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mPending;
+        }
+        mDone.notify_one();
+    }
+}
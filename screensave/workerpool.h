@@ -0,0 +1,44 @@
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//========================================================================
+// A small fixed set of worker threads that all run the same task over
+// a range of slices.  The calling thread always runs slice 0 itself, so
+// a pool of size 1 never touches another thread.
+class WorkerPool
+{
+public:
+    typedef std::function<void(int)>    task_t;
+
+                    WorkerPool(int size);
+                    ~WorkerPool();
+
+    int             getSize() const { return (int)mThreads.size() + 1; }
+
+    // Run task(slice) for every slice in [0, slices) and wait for all of
+    // them to finish.  slices is clamped to the size of the pool.
+    void            run(int slices, const task_t &task);
+
+private:
+    void            worker(int slice);
+
+    std::vector<std::thread>    mThreads;
+    std::mutex                  mMutex;
+    std::condition_variable     mStart;
+    std::condition_variable     mDone;
+
+    const task_t *  mTask;
+    int             mSlices;
+    int             mPending;
+    unsigned        mGeneration;
+    bool            mShutdown;
+};
+
+#endif // !WORKERPOOL_H
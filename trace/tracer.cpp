@@ -0,0 +1,168 @@
+/**
+ */
+
+#include "tracer.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+//========================================================================
+namespace
+{
+    const size_t RING_EVENTS(1 << 16);  // per thread, the newest are kept
+
+    struct TraceEvent
+    {
+        const char *    mName;
+        uint64_t        mStart;
+        uint64_t        mEnd;
+    };
+
+    struct ThreadRing
+    {
+        explicit ThreadRing(int thread):
+            mEvents(RING_EVENTS),
+            mCount(0),
+            mThread(thread)
+        {}
+
+        std::vector<TraceEvent> mEvents;
+        uint64_t        mCount;
+        int             mThread;
+    };
+
+    std::mutex gMutex;
+    std::vector<std::unique_ptr<ThreadRing>> gRings;
+    std::string gFilename;
+    uint64_t gOrigin(0);
+
+    thread_local ThreadRing *tRing(nullptr);
+
+    /// The calling thread's ring, registered on its first event.
+    ThreadRing &get_ring()
+    {
+        if (!tRing)
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            gRings.push_back(std::make_unique<ThreadRing>(int(gRings.size()) + 1));
+            tRing = gRings.back().get();
+        }
+        return *tRing;
+    }
+
+    void write_name(std::ostream &out, const char *name)
+    {
+        out << '"';
+        for (const char *ch = name; *ch; ++ch)
+        {
+            if ((*ch == '"') || (*ch == '\\'))
+                out << '\\';
+            out << *ch;
+        }
+        out << '"';
+    }
+
+    /// Chrome trace times are microseconds.
+    void write_micros(std::ostream &out, uint64_t nanoseconds)
+    {
+        out << (nanoseconds / 1000) << '.' << std::setw(3) << std::setfill('0') << (nanoseconds % 1000);
+    }
+}
+
+//========================================================================
+std::atomic<bool> Tracer::sEnabled(false);
+
+bool Tracer::enable(const std::string &filename)
+{
+#ifdef FALLOUT_TRACING
+    std::lock_guard<std::mutex> lock(gMutex);
+    gFilename = filename;
+    gOrigin = now();
+    sEnabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+uint64_t Tracer::now()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::record(const char *name, uint64_t start, uint64_t end)
+{
+    ThreadRing &ring(get_ring());
+    TraceEvent &event(ring.mEvents[ring.mCount++ % RING_EVENTS]);
+
+    event.mName = name;
+    event.mStart = start;
+    event.mEnd = end;
+}
+
+//------------------------------------------------------------------------
+bool Tracer::write()
+{
+    if (!sEnabled.exchange(false))
+        return true;
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    std::ofstream out(gFilename);
+    if (!out)
+    {
+        std::cerr << "Unable to write trace \"" << gFilename << "\"" << std::endl;
+        return false;
+    }
+
+    int pid(static_cast<int>(getpid()));
+    uint64_t dropped(0);
+    bool first(true);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    for (const std::unique_ptr<ThreadRing> &ring : gRings)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid <<
+            ",\"tid\":" << ring->mThread << ",\"args\":{\"name\":\"thread " << ring->mThread << "\"}}";
+        first = false;
+
+        uint64_t begin((ring->mCount > RING_EVENTS) ? (ring->mCount - RING_EVENTS) : 0);
+        dropped += begin;
+        for (uint64_t i = begin; i < ring->mCount; ++i)
+        {
+            const TraceEvent &event(ring->mEvents[i % RING_EVENTS]);
+            if (event.mStart < gOrigin)
+                continue;
+
+            out << ",\n{\"name\":";
+            write_name(out, event.mName);
+            out << ",\"pid\":" << pid << ",\"tid\":" << ring->mThread << ",\"ts\":";
+            write_micros(out, event.mStart - gOrigin);
+            if (event.mEnd == event.mStart)
+            {
+                out << ",\"ph\":\"i\",\"s\":\"t\"}";
+            }
+            else
+            {
+                out << ",\"ph\":\"X\",\"dur\":";
+                write_micros(out, event.mEnd - event.mStart);
+                out << '}';
+            }
+        }
+    }
+    out << "\n],\"otherData\":{\"dropped\":" << dropped << "}}\n";
+
+    out.close();
+    if (!out)
+    {
+        std::cerr << "Unable to write trace \"" << gFilename << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
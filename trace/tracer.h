@@ -0,0 +1,79 @@
+/**
+ */
+
+#ifndef TRACE_TRACER_H
+#define TRACE_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//========================================================================
+// Timing spans written as Chrome trace JSON, which Perfetto and
+// chrome://tracing load directly.  Each thread records into its own
+// fixed ring of the most recent events, so recording is two clock reads
+// and a store with no locks.  The rings are written out by
+// Tracer::write() once the traced threads are idle.
+//
+// The TRACE_ macros compile to nothing unless FALLOUT_TRACING is
+// defined (cmake -DFALLOUT_TRACING=ON).  When compiled in, nothing is
+// recorded until Tracer::enable().
+class Tracer
+{
+public:
+    /// Start recording, write() then goes to filename.  Returns false if
+    /// tracing was compiled out.
+    static bool             enable(const std::string &filename);
+    static bool             isEnabled()
+    {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t         now();
+
+    /// A span of [start, end) nanoseconds, or an instant if they match.
+    /// name must outlive the tracer, it is kept as a pointer.
+    static void             record(const char *name, uint64_t start, uint64_t end);
+
+    /// Write every thread's events and stop recording.
+    static bool             write();
+
+private:
+    static std::atomic<bool> sEnabled;
+};
+
+//========================================================================
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name):
+        mName(name),
+        mStart(Tracer::isEnabled() ? Tracer::now() : 0)
+    {}
+
+    ~TraceSpan()
+    {
+        if (mStart)
+            Tracer::record(mName, mStart, Tracer::now());
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *            mName;
+    uint64_t                mStart;
+};
+
+#define TRACE_CONCAT_INNER(a, b)    a##b
+#define TRACE_CONCAT(a, b)          TRACE_CONCAT_INNER(a, b)
+
+#ifdef FALLOUT_TRACING
+#define TRACE_SPAN(name)        TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define TRACE_INSTANT(name)     do { if (Tracer::isEnabled()) { uint64_t trace_now(Tracer::now()); Tracer::record(name, trace_now, trace_now); } } while (0)
+#else
+#define TRACE_SPAN(name)        do {} while (0)
+#define TRACE_INSTANT(name)     do {} while (0)
+#endif
+
+#endif // !TRACE_TRACER_H